@@ -3,29 +3,32 @@
 
 #include<iostream>
 #include<string>
+#include "InternTable.h"
 
+// One booked place. The doctor and time come from the slot that holds it;
+// IDs and names are interned, so the record is 16 bytes with no heap data.
 class Appointment{
     private:
-        std::string doctorID;
-        std::string patientID;
-        std::string patientName; // may be duplicated for convenience
-        std::string timeSlot; // e.g., "09:00"
+        NameId patientID; // NO_NAME marks a removed entry in AppointmentList
+        NameId patientName;
         int priLevel;
+        int triageOrder; // order of this booking's TriageEntry (FIFO tie-break)
     public:
-        Appointment(const std::string& doctorID,
-                const std::string& patientID,
-                const std::string& patientName,
-                const std::string& timeSlot,
-                int priorityLevel)
-        : doctorID(doctorID),
-          patientID(patientID),
+        Appointment(NameId patientID, NameId patientName, int priorityLevel, int order = 0)
+        : patientID(patientID),
           patientName(patientName),
-          timeSlot(timeSlot),
-          priLevel(priorityLevel) {};
+          priLevel(priorityLevel),
+          triageOrder(order) {};
+        Appointment(const std::string& patientID, const std::string& patientName,
+                    int priorityLevel, int order = 0)
+        : Appointment(names().intern(patientID), names().intern(patientName), priorityLevel, order) {};
 
-        const std::string& getPatientID() const { return patientID; }
-        const std::string& getPatientName() const { return patientName; }
+        const std::string& getPatientID() const { return names().str(patientID); }
+        const std::string& getPatientName() const { return names().str(patientName); }
+        NameId getPatientKey() const { return patientID; }
+        NameId getPatientNameKey() const { return patientName; }
         int getPriorityLevel() const { return priLevel; }
+        int getTriageOrder() const { return triageOrder; }
 };
 
 #endif
@@ -0,0 +1,240 @@
+#ifndef APPOINTMENTJOURNAL_H
+#define APPOINTMENTJOURNAL_H
+
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+#include <fstream>
+#include <sstream>
+#include <string>
+#ifdef _WIN32
+#include <io.h>
+#define fsync _commit
+#else
+#include <unistd.h>
+#endif
+
+// Operation codes written at the start of every journal line. A journal that
+// was started by compaction begins with "E <epoch>"; hospital.snapshot records
+// the last epoch it contains, so a journal left over from an interrupted
+// compaction is recognised and not applied twice.
+enum JournalOp : char {
+    JOURNAL_EPOCH    = 'E', // first line of a journal started by compaction
+    JOURNAL_SCHEDULE = 'S', // appointment booked
+    JOURNAL_WAITLIST = 'W', // patient added to a slot's waiting list
+    JOURNAL_CANCEL   = 'X', // appointment cancelled
+    JOURNAL_CALL     = 'C', // patient called by the doctor
+    JOURNAL_PROMOTE  = 'P'  // patient moved from waiting list into the slot
+};
+
+struct JournalRecord{
+    char op;
+    std::string doctorID;
+    std::string timeSlot;
+    std::string patientID;
+    std::string patientName; // only for S/W/P
+    int priorityLevel;       // only for S/W/P
+};
+
+// Records collected by a bulk operation, written by AppointmentJournal::commit
+// in one write with one fsync.
+class JournalBatch{
+    private:
+        std::string lines;
+        int count;
+
+        void field(const std::string& s){
+            lines += ' ';
+            lines += s;
+        };
+    public:
+        JournalBatch() : count(0) {};
+        void add(JournalOp op, const std::string& doctorID, const std::string& timeSlot,
+                 const std::string& patientID, const std::string& patientName, int priorityLevel){
+            lines += static_cast<char>(op);
+            field(doctorID);
+            field(timeSlot);
+            field(patientID);
+            field(patientName);
+            field(std::to_string(priorityLevel));
+            lines += '\n';
+            count++;
+        };
+        bool empty() const { return count == 0; };
+        int size() const { return count; };
+        const std::string& text() const { return lines; };
+};
+
+// Append-only log of appointment mutations. Each operation costs one short
+// line instead of a rewrite of appointments.txt; the file is fsync'ed every
+// syncEvery records and compacted by HospitalSystem once it grows past
+// compactEvery records.
+//
+// Safe to append from several threads: a line is written under a short
+// mutex, and the batched fsync runs after the mutex is released so other
+// appenders are not held up by the disk.
+class AppointmentJournal{
+    private:
+        std::string path;
+        FILE* out;
+        std::mutex lock;
+        int unsynced;
+        int groups; // open group commits; while > 0 nothing is fsync'ed
+        std::atomic<int> records;
+        int epoch;
+        int syncEvery;
+        int compactEvery;
+
+        void openForAppend(){
+            if(!out){
+                out = std::fopen(path.c_str(), "a");
+            };
+        };
+    public:
+        AppointmentJournal(const std::string& journalPath, int syncBatch = 32, int compactThreshold = 4096)
+        : path(journalPath), out(nullptr), unsynced(0), groups(0), records(0), epoch(0),
+          syncEvery(syncBatch), compactEvery(compactThreshold) {};
+        AppointmentJournal(const AppointmentJournal&) = delete;
+        AppointmentJournal& operator=(const AppointmentJournal&) = delete;
+        ~AppointmentJournal(){
+            sync();
+            if(out){
+                std::fclose(out);
+            };
+        };
+
+        void append(JournalOp op, const std::string& doctorID, const std::string& timeSlot,
+                    const std::string& patientID){
+            int fd = -1;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                openForAppend();
+                if(!out) return;
+                std::fprintf(out, "%c %s %s %s\n", static_cast<char>(op),
+                             doctorID.c_str(), timeSlot.c_str(), patientID.c_str());
+                fd = written();
+            }
+            if(fd >= 0) fsync(fd);
+        };
+        void append(JournalOp op, const std::string& doctorID, const std::string& timeSlot,
+                    const std::string& patientID, const std::string& patientName, int priorityLevel){
+            int fd = -1;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                openForAppend();
+                if(!out) return;
+                std::fprintf(out, "%c %s %s %s %s %d\n", static_cast<char>(op),
+                             doctorID.c_str(), timeSlot.c_str(), patientID.c_str(),
+                             patientName.c_str(), priorityLevel);
+                fd = written();
+            }
+            if(fd >= 0) fsync(fd);
+        };
+        void commit(const JournalBatch& batch){
+            if(batch.empty()) return;
+            int fd = -1;
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                openForAppend();
+                if(!out) return;
+                std::fwrite(batch.text().data(), 1, batch.text().size(), out);
+                std::fflush(out);
+                records += batch.size();
+                if(groups > 0){
+                    unsynced += batch.size();
+                    return;
+                };
+                unsynced = 0;
+                fd = fileno(out);
+            }
+            fsync(fd);
+        };
+        // Group commit: between begin and end, appends and batches are still
+        // written at once but not fsync'ed; endGroupCommit syncs everything
+        // written so far with one fsync. Callers that acknowledge work (the
+        // command stream) answer only after endGroupCommit.
+        void beginGroupCommit(){
+            std::lock_guard<std::mutex> guard(lock);
+            groups++;
+        };
+        void endGroupCommit(){
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                groups--;
+            }
+            sync();
+        };
+        // Returns the descriptor to fsync once the lock is released, or -1.
+        int written(){
+            // Hand the line to the kernel right away so a crashed process
+            // loses nothing; only the disk flush is batched.
+            std::fflush(out);
+            records++;
+            if(++unsynced >= syncEvery && groups == 0){
+                unsynced = 0;
+                return fileno(out);
+            };
+            return -1;
+        };
+        void sync(){
+            std::lock_guard<std::mutex> guard(lock);
+            if(!out || unsynced == 0) return;
+            std::fflush(out);
+            fsync(fileno(out));
+            unsynced = 0;
+        };
+        bool needsCompaction() const { return records >= compactEvery; };
+        int getEpoch() const { return epoch; };
+        int getRecordCount() const { return records; };
+        // Epoch of the journal on disk; 0 for a missing file or one written
+        // before epochs existed.
+        int readEpoch(){
+            std::ifstream in(path);
+            std::string op;
+            int value = 0;
+            epoch = (in >> op >> value && op.size() == 1 && op[0] == JOURNAL_EPOCH) ? value : 0;
+            return epoch;
+        };
+        // Called once the snapshot on disk reflects every journaled record,
+        // with no appends running (HospitalSystem holds its registry lock).
+        void reset(int newEpoch){
+            std::lock_guard<std::mutex> guard(lock);
+            if(out){
+                std::fclose(out);
+            };
+            out = std::fopen(path.c_str(), "w");
+            unsynced = 0;
+            records = 0;
+            epoch = newEpoch;
+            if(!out) return;
+            std::fprintf(out, "%c %d\n", static_cast<char>(JOURNAL_EPOCH), epoch);
+            std::fflush(out);
+            fsync(fileno(out));
+        };
+
+        // Replays every complete record in order; a torn trailing line from a
+        // crash ends the replay.
+        template <typename Apply>
+        int replay(Apply apply){
+            std::ifstream in(path);
+            if(!in) return 0;
+            std::string line;
+            int count = 0;
+            while(std::getline(in, line)){
+                if(!line.empty() && line[0] == JOURNAL_EPOCH) continue;
+                std::istringstream fields(line);
+                JournalRecord r;
+                r.priorityLevel = 0;
+                if(!(fields >> r.op >> r.doctorID >> r.timeSlot >> r.patientID)) break;
+                if(r.op == JOURNAL_SCHEDULE || r.op == JOURNAL_WAITLIST || r.op == JOURNAL_PROMOTE){
+                    if(!(fields >> r.patientName >> r.priorityLevel)) break;
+                };
+                apply(r);
+                count++;
+            };
+            records = count;
+            return count;
+        };
+};
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef APPOINTMENTLIST_H
+#define APPOINTMENTLIST_H
+
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Appointment.h"
+
+// Appointments of one slot in booking order, found by interned patient ID.
+// A removed appointment is only marked dead (NO_NAME) and skipped while
+// iterating, and the storage is compacted once dead entries outnumber live
+// ones, so iteration order never changes. Small slots, the common case, are
+// searched linearly over their 16-byte records; a hash index is built only
+// once a slot grows past INDEX_FROM entries.
+class AppointmentList{
+    private:
+        static const size_t INDEX_FROM = 16;
+
+        std::vector<Appointment> items;
+        std::unordered_map<NameId, size_t> index; // patientID -> position, large slots only
+        size_t live;
+
+        static bool isDead(const Appointment& a){ return a.getPatientKey() == NO_NAME; };
+
+        size_t position(NameId patientID) const{
+            if(patientID == NO_NAME) return items.size();
+            if(!index.empty()){
+                auto it = index.find(patientID);
+                return it == index.end() ? items.size() : it->second;
+            };
+            for(size_t i = 0; i < items.size(); i++){
+                if(items[i].getPatientKey() == patientID) return i;
+            };
+            return items.size();
+        };
+        void rebuildIndex(){
+            index.clear();
+            if(live <= INDEX_FROM) return;
+            for(size_t i = 0; i < items.size(); i++){
+                if(!isDead(items[i])) index[items[i].getPatientKey()] = i;
+            };
+        };
+        void compact(){
+            size_t out = 0;
+            for(size_t i = 0; i < items.size(); i++){
+                if(isDead(items[i])) continue;
+                items[out++] = items[i];
+            };
+            items.erase(items.begin() + out, items.end());
+            rebuildIndex();
+        };
+    public:
+        class const_iterator{
+            private:
+                const AppointmentList* list;
+                size_t pos;
+                void skipDead(){
+                    while(pos < list->items.size() && isDead(list->items[pos])) pos++;
+                };
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef Appointment value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const Appointment* pointer;
+                typedef const Appointment& reference;
+
+                const_iterator(const AppointmentList* l, size_t p) : list(l), pos(p) { skipDead(); };
+                reference operator*() const { return list->items[pos]; };
+                pointer operator->() const { return &list->items[pos]; };
+                const_iterator& operator++(){ pos++; skipDead(); return *this; };
+                bool operator==(const const_iterator& o) const { return pos == o.pos; };
+                bool operator!=(const const_iterator& o) const { return pos != o.pos; };
+        };
+
+        AppointmentList() : live(0) {};
+
+        // Returns false if the patient already holds an appointment here.
+        bool push_back(const Appointment& a){
+            if(position(a.getPatientKey()) != items.size()) return false;
+            items.push_back(a);
+            live++;
+            if(!index.empty()){
+                index[a.getPatientKey()] = items.size() - 1;
+            }else if(live > INDEX_FROM){
+                rebuildIndex();
+            };
+            return true;
+        };
+        bool erase(NameId patientID){
+            size_t pos = position(patientID);
+            if(pos == items.size()) return false;
+            items[pos] = Appointment(NO_NAME, NO_NAME, 0);
+            live--;
+            if(!index.empty()) index.erase(patientID);
+            size_t dead = items.size() - live;
+            if(dead > 16 && dead > live){
+                compact();
+            };
+            return true;
+        };
+        bool contains(NameId patientID) const { return position(patientID) != items.size(); };
+        const Appointment* find(NameId patientID) const{
+            size_t pos = position(patientID);
+            return pos == items.size() ? nullptr : &items[pos];
+        };
+        size_t size() const { return live; };
+        bool empty() const { return live == 0; };
+        const_iterator begin() const { return const_iterator(this, 0); };
+        const_iterator end() const { return const_iterator(this, items.size()); };
+};
+
+#endif
@@ -0,0 +1,125 @@
+#ifndef AVAILABILITY_H
+#define AVAILABILITY_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "SlotTime.h"
+
+// Weekday bits of AvailabilityRule::weekdays, Monday first.
+const char* const WEEKDAY_NAMES[7] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+
+// 1970-01-01, day 0, was a Thursday.
+inline int weekdayOf(int day){ return (day + 3) % 7; }
+
+// One recurring block of slots: on the given weekdays, a slot every `step`
+// minutes from `from` up to (not including) `to`, each with `capacity`
+// places. E.g. Mon-Fri 09:00-12:00 every 15 minutes, capacity 4.
+struct AvailabilityRule{
+    uint8_t weekdays; // bit i = WEEKDAY_NAMES[i]
+    int from;         // minute of day
+    int to;
+    int step;
+    int capacity;
+
+    bool valid() const{
+        return weekdays != 0 && weekdays < 0x80 && from >= 0 && from < to &&
+               to <= MINUTES_PER_DAY && step > 0 && capacity > 0;
+    };
+    bool offers(int day, int minute) const{
+        return (weekdays >> weekdayOf(day) & 1) && minute >= from && minute < to &&
+               (minute - from) % step == 0;
+    };
+    // First slot of this rule at or after `minute` on `day`, or -1.
+    int firstFrom(int day, int minute) const{
+        if(!(weekdays >> weekdayOf(day) & 1)) return -1;
+        int m = minute <= from ? from : from + (minute - from + step - 1) / step * step;
+        return m < to ? m : -1;
+    };
+};
+
+// "Mon-Fri", "Sat", "Mon,Wed,Fri" or a mix like "Mon-Wed,Sat"; false if not.
+inline bool parseWeekdays(std::string_view text, uint8_t& weekdays){
+    auto dayIndex = [](std::string_view name){
+        for(int i = 0; i < 7; i++){
+            if(name == WEEKDAY_NAMES[i]) return i;
+        };
+        return -1;
+    };
+    weekdays = 0;
+    while(!text.empty()){
+        size_t comma = text.find(',');
+        std::string_view part = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view() : text.substr(comma + 1);
+        size_t dash = part.find('-');
+        int first = dayIndex(part.substr(0, dash));
+        int last = dash == std::string_view::npos ? first : dayIndex(part.substr(dash + 1));
+        if(first < 0 || last < first) return false;
+        for(int i = first; i <= last; i++) weekdays |= static_cast<uint8_t>(1 << i);
+    };
+    return weekdays != 0;
+}
+
+inline std::string formatWeekdays(uint8_t weekdays){
+    std::string out;
+    for(int i = 0; i < 7; i++){
+        if(!(weekdays >> i & 1)) continue;
+        int last = i;
+        while(last + 1 < 7 && (weekdays >> (last + 1) & 1)) last++;
+        if(!out.empty()) out += ',';
+        out += WEEKDAY_NAMES[i];
+        if(last > i){
+            out += '-';
+            out += WEEKDAY_NAMES[last];
+        };
+        i = last;
+    };
+    return out;
+}
+
+// Builds a rule from its text form, "Mon-Fri 09:00 12:00 15 4"; false if
+// any part is malformed or the rule is empty.
+inline bool parseAvailabilityRule(std::string_view weekdays, std::string_view from, std::string_view to,
+                                  int step, int capacity, AvailabilityRule& rule){
+    rule = AvailabilityRule{0, parseClock(from), parseClock(to), step, capacity};
+    // "24:00" cannot be parsed as a clock time but is a natural end of day.
+    if(to == "24:00") rule.to = MINUTES_PER_DAY;
+    return parseWeekdays(weekdays, rule.weekdays) && rule.valid();
+}
+
+// A doctor's recurring weekly availability. Nothing is stored per date: a
+// slot the rules offer only becomes a TimeSlotInfo once someone books it.
+// The first rule that offers a time decides its capacity.
+class Availability{
+    private:
+        std::vector<AvailabilityRule> rules;
+    public:
+        void add(const AvailabilityRule& rule){ rules.push_back(rule); };
+        bool empty() const { return rules.empty(); };
+        const std::vector<AvailabilityRule>& getRules() const { return rules; };
+
+        // Places the rules give the slot at `key`, 0 if they do not offer it.
+        int capacityAt(int key) const{
+            for(const AvailabilityRule& r : rules){
+                if(r.offers(slotDay(key), slotMinuteOfDay(key))) return r.capacity;
+            };
+            return 0;
+        };
+        // First offered slot key at or after `key`, or -1. Rules repeat
+        // weekly, so a week past the first day is as far as it can be.
+        int nextOffered(int key) const{
+            int day = slotDay(key), minute = slotMinuteOfDay(key);
+            for(int d = day; d <= day + 7; d++, minute = 0){
+                int best = -1;
+                for(const AvailabilityRule& r : rules){
+                    int m = r.firstFrom(d, minute);
+                    if(m >= 0 && (best < 0 || m < best)) best = m;
+                };
+                if(best >= 0) return d * MINUTES_PER_DAY + best;
+            };
+            return -1;
+        };
+};
+
+#endif
@@ -0,0 +1,1041 @@
+// Benchmark suite for the scheduling engine. Every section runs headless in
+// a scratch directory:
+//
+//   loader      mmap/string_view loader vs. the previous std::ifstream >>
+//               loader vs. restoring from hospital.snapshot
+//   import      one scheduleAppointment call per referral vs. one
+//               scheduleAppointments batch
+//   assign      scheduleBySpecialty latency over thousands of doctors of
+//               one specialty
+//   memory      heap bytes held per loaded booking (appointment, triage
+//               entry, patient index entry) and the time to load them
+//   workload    synthetic hospital: N doctors, M slots each, skewed
+//               priorities and a schedule/cancel/call/list mix; ops/s and
+//               p50/p99 latency per operation, reload time, peak RSS
+//   days        loading a snapshot that holds past days (archived on the
+//               way) and reloading once they are gone
+//   nearest     next slot with a free place: index vs scanning the schedule,
+//               and the book-nearest mode
+//   triage      simulated clinic days on one call queue: waits per priority
+//               level under the static rule, aging and wait limits, and
+//               aging of slots still ahead of the clock
+//   availability  doctors with weekly availability rules vs. the same
+//               slots created explicitly: heap and auto-assign latency
+//   commands    one synthetic day replayed through runMenu and through the
+//               headless command stream (runCommands)
+//   history     the same operation mix without an event sink and with the
+//               history exporter, then a streaming read of its chunks
+//   server      the socket server on a Unix socket under the pipelining
+//               load generator: commands/s and latency at depth 1 and N
+//   stress      several threads on shared doctors, then checkInvariants;
+//               a failure makes the program exit non-zero
+//   throughput  schedule/cancel ops/s on disjoint doctors at 1, 2, 4, ...
+//               threads
+//   reports     one booking thread alone and next to dashboard threads
+//               reading published schedule views
+//
+//   g++ -std=c++17 -O2 -pthread Benchmark.cpp -o hospital_bench
+//   ./hospital_bench [section ...] [key=value ...]
+//
+// Keys (defaults): lines=1000000 referrals=100000 doctors=200 slots=96
+// ops=500000 schedule=60 cancel=20 call=15 list=5 seed=1 threads=8
+// assignDoctors=5000 assignRequests=20000 bookings=1000000 pastDays=30
+// perDay=20000 nearestDays=365 nearestQueries=5000 triageDays=200
+// triagePatients=110 availabilityDoctors=200
+// availabilityBookings=20000
+// commandOps=200000 historyOps=200000 serverOps=100000 connections=4 depth=16
+// reportOps=200000 readers=(cores - 1)
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <set>
+#include <thread>
+#include <sys/resource.h>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "HospitalSystem.h"
+#include "HospitalSystem.cpp"
+#include "HistoryExport.h"
+#include "CommandServer.h"
+#include "CommandClient.h"
+
+typedef std::chrono::steady_clock BenchClock;
+
+static double elapsedMs(BenchClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(BenchClock::now() - start).count();
+}
+
+// Peak resident set size of the whole process so far, in MiB.
+static double peakRssMb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+// Heap bytes in use right now; 0 where the C library cannot tell.
+static size_t heapInUse() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+// Writes doctors.txt / appointments.txt with two patients per slot (the
+// default capacity), one slot per minute from 08:00, 480 slots per doctor.
+static int writeLoaderFixture(int appointmentLines) {
+    const int slotsPerDoctor = 480;
+    int doctorCount = appointmentLines / (2 * slotsPerDoctor) + 1;
+
+    FILE* doctorsOut = std::fopen("doctors.txt", "w");
+    FILE* apptOut = std::fopen("appointments.txt", "w");
+    int written = 0;
+    for (int d = 0; d < doctorCount; d++) {
+        std::fprintf(doctorsOut, "D%05d Doctor%d Specialty%d\n", d, d, d % 12);
+        for (int s = 0; s < slotsPerDoctor && written < appointmentLines; s++) {
+            int minute = 8 * 60 + s;
+            for (int k = 0; k < 2 && written < appointmentLines; k++, written++) {
+                std::fprintf(apptOut, "D%05d %02d:%02d P%07d Patient%d %d\n",
+                             d, minute / 60, minute % 60, written, written, written % 5);
+            }
+        }
+    }
+    std::fclose(doctorsOut);
+    std::fclose(apptOut);
+    return doctorCount;
+}
+
+// The loader as it was before the mmap parser (iostream tokens, string-keyed
+// std::map schedules), kept here as the baseline; records are built with
+// today's types.
+static size_t loadWithIostream() {
+    std::map<std::string, Doctor> doctors;
+    std::map<std::string, std::map<std::string, TimeSlotInfo>> schedules;
+    std::map<std::string, TriageQueue> triageQueues;
+    int triageOrderCounter = 0;
+
+    std::ifstream din("doctors.txt");
+    std::string id, name, spec;
+    while (din >> id >> name >> spec) {
+        doctors.emplace(id, Doctor(id, name, spec));
+    }
+
+    std::ifstream in("appointments.txt");
+    std::string doctorID, timeSlot, patientID, patientName;
+    int priorityLevel;
+    size_t loaded = 0;
+    while (in >> doctorID >> timeSlot >> patientID >> patientName >> priorityLevel) {
+        auto it = doctors.find(doctorID);
+        if (it == doctors.end()) continue;
+
+        std::map<std::string, TimeSlotInfo>& schedule = schedules[doctorID];
+        auto slotIt = schedule.find(timeSlot);
+        if (slotIt == schedule.end()) {
+            slotIt = schedule.emplace(timeSlot, TimeSlotInfo(parseSlotTime(timeSlot, currentDay()), 2)).first;
+        }
+
+        Appointment a(patientID, patientName, priorityLevel);
+        slotIt->second.addAppointment(a);
+        triageQueues[doctorID].push({priorityLevel, a.getPatientKey(), a.getPatientNameKey(),
+                                     names().intern(doctorID), slotIt->second.getMinute(),
+                                     triageOrderCounter++});
+        loaded++;
+    }
+    return loaded;
+}
+
+static void benchLoaders(int appointmentLines, int rounds) {
+    int doctorCount = writeLoaderFixture(appointmentLines);
+    std::cout << "loader: " << appointmentLines << " appointments, "
+              << doctorCount << " doctors, best of " << rounds << "\n";
+
+    double bestIostream = 1e300, bestMapped = 1e300;
+    for (int r = 0; r < rounds; r++) {
+        BenchClock::time_point start = BenchClock::now();
+        size_t loaded = loadWithIostream();
+        bestIostream = std::min(bestIostream, elapsedMs(start));
+        if (loaded != static_cast<size_t>(appointmentLines))
+            std::cout << "  iostream loader read " << loaded << " records\n";
+
+        start = BenchClock::now();
+        {
+            HospitalSystem system;
+        }
+        bestMapped = std::min(bestMapped, elapsedMs(start));
+    }
+
+    {
+        HospitalSystem system;
+        system.saveSnapshot();
+    }
+    std::rename("appointments.txt", "appointments.txt.bench");
+    double bestSnapshot = 1e300;
+    for (int r = 0; r < rounds; r++) {
+        BenchClock::time_point start = BenchClock::now();
+        {
+            HospitalSystem system;
+        }
+        bestSnapshot = std::min(bestSnapshot, elapsedMs(start));
+    }
+    std::rename("appointments.txt.bench", "appointments.txt");
+    std::remove("hospital.snapshot");
+    std::remove("appointments.archive");
+    std::remove("availability.txt");
+    std::remove("bench.sock");
+
+    std::printf("  %-22s %10.1f ms\n", "iostream (previous)", bestIostream);
+    std::printf("  %-22s %10.1f ms  (%.2fx)\n", "mmap + string_view", bestMapped,
+                bestIostream / bestMapped);
+    std::printf("  %-22s %10.1f ms  (%.2fx)\n", "binary snapshot", bestSnapshot,
+                bestIostream / bestSnapshot);
+}
+
+static void removeSystemFiles();
+
+static void benchMemory(int bookings) {
+    removeSystemFiles();
+    int doctorCount = writeLoaderFixture(bookings);
+    size_t before = heapInUse();
+    BenchClock::time_point start = BenchClock::now();
+    HospitalSystem system;
+    double loadMs = elapsedMs(start);
+    size_t held = heapInUse() - before;
+    std::printf("memory: %d bookings, %d doctors\n", bookings, doctorCount);
+    std::printf("  heap %.1f MiB, %.1f bytes per booking, load %.1f ms\n",
+                held / (1024.0 * 1024.0), static_cast<double>(held) / bookings, loadMs);
+}
+
+// A month of past days plus today and a week ahead in appointments.txt. The
+// first start archives the past days while streaming them; the second only
+// reads what is left.
+static void benchDays(int pastDays, int perDay) {
+    removeSystemFiles();
+    const int doctorCount = 100, futureDays = 7;
+    FILE* doctorsOut = std::fopen("doctors.txt", "w");
+    for (int d = 0; d < doctorCount; d++) std::fprintf(doctorsOut, "C%d Doctor General\n", d);
+    std::fclose(doctorsOut);
+    int today = currentDay();
+    FILE* out = std::fopen("appointments.txt", "w");
+    for (int d = 0; d < doctorCount; d++) {
+        for (int day = today - pastDays; day <= today + futureDays; day++) {
+            for (int i = 0; i < perDay / doctorCount; i++) {
+                std::fprintf(out, "C%d %sT%s P%d_%d Name %d\n", d, formatDate(day).c_str(),
+                             formatClock(8 * 60 + i / 2 * 5).c_str(), day, d * perDay + i, i % 5 + 1);
+            }
+        }
+    }
+    std::fclose(out);
+
+    int totalDays = pastDays + 1 + futureDays;
+    for (int round = 0; round < 2; round++) {
+        size_t before = heapInUse();
+        BenchClock::time_point start = BenchClock::now();
+        HospitalSystem system;
+        double loadMs = elapsedMs(start);
+        size_t held = heapInUse() - before;
+        if (round == 0)
+            std::printf("days: %d days x %d bookings on disk, %d from today on\n", totalDays, perDay,
+                        futureDays + 1);
+        std::printf("  %s load %.1f ms, heap %.1f MiB\n", round == 0 ? "first (archiving)" : "second",
+                    loadMs, held / (1024.0 * 1024.0));
+    }
+}
+
+static void removeSystemFiles() {
+    std::remove("doctors.txt");
+    std::remove("appointments.txt");
+    std::remove("appointments.journal");
+    std::remove("hospital.snapshot");
+    std::remove("appointments.archive");
+    std::remove("availability.txt");
+    for (int i = 0; ; i++) {
+        char path[32];
+        std::snprintf(path, sizeof path, "history-%05d.csv", i);
+        if (std::remove(path) != 0 && std::remove((path + std::string(".part")).c_str()) != 0) break;
+    }
+}
+
+static std::string slotName(int minute) {
+    return formatClock(minute);
+}
+
+// Threads book and cancel the same few patients on the same doctors and
+// minutes, so every path (full slots, waiting lists, promotions, duplicate
+// rejections, compaction) races against the others.
+static bool stressSharedDoctors(int threads, int opsPerThread) {
+    removeSystemFiles();
+    HospitalSystem system;
+    const int doctorCount = 4, minutes = 6, patients = 40;
+    for (int d = 0; d < doctorCount; d++)
+        system.addDoctor(Doctor("S" + std::to_string(d), "Stress", "General"));
+    // One doctor works from availability rules, so its slots come and go.
+    system.addAvailability("S0", AvailabilityRule{0x7F, 9 * 60, 9 * 60 + minutes, 1, 2});
+
+    // A dashboard reads the published views the whole time, without locks.
+    std::atomic<bool> done(false);
+    size_t viewsRead = 0, namesSeen = 0;
+    std::thread reader([&]() {
+        for (; !done; viewsRead++) {
+            std::shared_ptr<const DoctorView> view = system.getDoctorView("S" + std::to_string(viewsRead % doctorCount));
+            for (const auto& day : view->days) {
+                for (const SlotView& s : day->slots) {
+                    const BookingView* b = day->bookings(s);
+                    for (int k = 0; k < s.booked + s.waiting; k++)
+                        namesSeen += names().str(b[k].patientName).empty() ? 0 : 1;
+                }
+            }
+        }
+    });
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&system, t, opsPerThread]() {
+            std::mt19937 rng(1234 + t);
+            for (int i = 0; i < opsPerThread; i++) {
+                std::string doctorID = "S" + std::to_string(rng() % doctorCount);
+                std::string slot = slotName(9 * 60 + static_cast<int>(rng() % minutes));
+                int patient = rng() % patients;
+                std::string patientID = "P" + std::to_string(patient);
+                int op = rng() % 7;
+                Patient p(patientID, "Name" + std::to_string(patient), static_cast<int>(rng() % 5) + 1);
+                if (op == 0)
+                    system.scheduleBySpecialty(p, "General", slot);
+                else if (op == 6)
+                    system.scheduleNearest(p, doctorID, slot);
+                else if (op < 4)
+                    system.scheduleAppointment(p, doctorID, slot);
+                else
+                    system.cancelAppointment(doctorID, slot, patientID);
+            }
+        });
+    }
+    for (std::thread& w : workers) w.join();
+    done = true;
+    reader.join();
+
+    std::string problem;
+    bool ok = system.checkInvariants(problem, true);
+    std::printf("stress: %d threads x %d ops on shared doctors (%zu schedule views read): %s\n", threads,
+                opsPerThread, viewsRead, ok ? "ok" : problem.c_str());
+    return ok;
+}
+
+// One front desk books and cancels on 50 doctors, first alone, then with
+// dashboard threads reading whole schedules (getDoctorView) the whole time.
+static void benchReports(int writerOps, int readers) {
+    const int doctorCount = 50, slots = 96;
+    std::printf("reports: %d schedule/cancel ops, %d reader threads\n", writerOps, readers);
+    for (int withReaders = 0; withReaders < 2; withReaders++) {
+        removeSystemFiles();
+        HospitalSystem system;
+        for (int d = 0; d < doctorCount; d++)
+            system.addDoctor(Doctor("R" + std::to_string(d), "Doctor", "General"));
+
+        std::atomic<bool> done(false);
+        std::atomic<size_t> reads(0), peopleSeen(0);
+        std::vector<std::thread> dashboards;
+        for (int r = 0; withReaders && r < readers; r++) {
+            dashboards.emplace_back([&system, &done, &reads, &peopleSeen, r]() {
+                size_t people = 0;
+                for (int i = r; !done; i++) {
+                    std::shared_ptr<const DoctorView> view = system.getDoctorView("R" + std::to_string(i % doctorCount));
+                    for (const auto& day : view->days)
+                        for (const SlotView& s : day->slots) people += s.booked + s.waiting;
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                }
+                peopleSeen += people;
+            });
+        }
+        std::mt19937 rng(9);
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < writerOps; i++) {
+            std::string doctorID = "R" + std::to_string(rng() % doctorCount);
+            std::string slot = slotName(8 * 60 + static_cast<int>(rng() % slots) * 5);
+            std::string patientID = "P" + std::to_string(rng() % 2000);
+            if (i % 3 == 2)
+                system.cancelAppointment(doctorID, slot, patientID);
+            else
+                system.scheduleAppointment(Patient(patientID, "Name", 3), doctorID, slot);
+        }
+        double ms = elapsedMs(start);
+        done = true;
+        for (std::thread& t : dashboards) t.join();
+        std::printf("  %-14s writer %8.0f ops/s", withReaders ? "with readers" : "writer alone", writerOps / (ms / 1000.0));
+        if (withReaders)
+            std::printf("   readers %8.0f schedule views/s", reads.load() / (ms / 1000.0));
+        std::printf("\n");
+    }
+}
+
+// Each thread owns its doctors, the common front-desk case; reports total
+// operations per second as threads are added.
+static void benchThroughput(int opsPerThread) {
+    unsigned maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("throughput: %d schedule/cancel ops per thread\n", opsPerThread);
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        removeSystemFiles();
+        HospitalSystem system;
+        for (unsigned t = 0; t < threads; t++)
+            system.addDoctor(Doctor("T" + std::to_string(t), "Throughput", "General"));
+
+        BenchClock::time_point start = BenchClock::now();
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            workers.emplace_back([&system, t, opsPerThread]() {
+                std::string doctorID = "T" + std::to_string(t);
+                for (int i = 0; i < opsPerThread; i++) {
+                    // Book two patients, cancel one: slots fill up over time.
+                    std::string slot = slotName(8 * 60 + (i / 2) % 480);
+                    std::string patientID = "P" + std::to_string(t) + "_" + std::to_string(i);
+                    if (i % 3 == 2)
+                        system.cancelAppointment(doctorID, slot,
+                                                 "P" + std::to_string(t) + "_" + std::to_string(i - 1));
+                    else
+                        system.scheduleAppointment(Patient(patientID, "Name", i % 5 + 1), doctorID, slot);
+                }
+            });
+        }
+        for (std::thread& w : workers) w.join();
+        double ms = elapsedMs(start);
+        std::printf("  %2u threads %10.1f ms  %12.0f ops/s\n", threads, ms,
+                     threads * opsPerThread / (ms / 1000.0));
+    }
+}
+
+// Latencies of one operation kind, in nanoseconds.
+struct LatencySamples {
+    const char* name;
+    std::vector<double> ns;
+
+    double percentile(double p) {
+        if (ns.empty()) return 0;
+        size_t k = std::min(ns.size() - 1, static_cast<size_t>(p * ns.size()));
+        std::nth_element(ns.begin(), ns.begin() + k, ns.end());
+        return ns[k];
+    }
+};
+
+// Auto-assignment over one large specialty: every doctor has `slots`
+// five-minute slots from 08:00 that fill up as the run goes on.
+static void benchAssign(int doctorCount, int slots, int requests) {
+    removeSystemFiles();
+    HospitalSystem system;
+    int day = system.getToday() * MINUTES_PER_DAY;
+    for (int d = 0; d < doctorCount; d++) {
+        Doctor doctor("A" + std::to_string(d), "Doctor", "Cardiology");
+        for (int m = 0; m < slots; m++)
+            doctor.addTimeSlot(day + 8 * 60 + m * 5, 2);
+        system.addDoctor(doctor);
+    }
+
+    std::mt19937 rng(3);
+    LatencySamples samples{"assign", {}};
+    size_t booked = 0;
+    for (int i = 0; i < requests; i++) {
+        std::string from = slotName(8 * 60 + static_cast<int>(rng() % (slots * 5)));
+        BenchClock::time_point t = BenchClock::now();
+        AssignResult r = system.scheduleBySpecialty(Patient("Q" + std::to_string(i), "Name", i % 5 + 1),
+                                                    "Cardiology", from);
+        samples.ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+        if (r.result.status == SCHEDULE_BOOKED) booked++;
+    }
+    std::printf("assign: %d doctors x %d slots, %d requests, %zu booked\n", doctorCount, slots,
+                requests, booked);
+    std::printf("  p50 %.1f us  p99 %.1f us\n", samples.percentile(0.50) / 1000.0,
+                samples.percentile(0.99) / 1000.0);
+}
+
+// One doctor with 96 five-minute slots a day for `days` days, all full but
+// one in 1000. "Next slot with a free place" asked of the index
+// (nextAvailableSlot) and found by scanning the published schedule view,
+// then booked with the book-nearest mode.
+static void benchNearest(int days, int queries) {
+    removeSystemFiles();
+    HospitalSystem system;
+    system.addDoctor(Doctor("N1", "Doctor", "General"));
+    int today = system.getToday();
+    std::vector<ScheduleRequest> batch;
+    std::vector<int> keys;
+    for (int day = today; day < today + days; day++) {
+        for (int m = 0; m < 96; m++) {
+            int key = day * MINUTES_PER_DAY + 8 * 60 + m * 5;
+            keys.push_back(key);
+            int places = keys.size() % 1000 == 0 ? 1 : 2;
+            for (int k = 0; k < places; k++)
+                batch.push_back({Patient("F" + std::to_string(batch.size()), "Name", 3), "N1", formatSlotTime(key)});
+        }
+    }
+    system.scheduleAppointments(batch);
+    std::printf("nearest: %zu slots over %d days, 1 in 1000 with a free place, %d queries\n",
+                keys.size(), days, queries);
+
+    std::mt19937 rng(9);
+    std::vector<std::string> from;
+    for (int i = 0; i < queries; i++) from.push_back(formatSlotTime(keys[rng() % keys.size()]));
+    LatencySamples index{"index", {}}, scan{"view scan", {}};
+    size_t mismatches = 0;
+    for (int i = 0; i < queries; i++) {
+        BenchClock::time_point t = BenchClock::now();
+        std::string found = system.nextAvailableSlot("N1", from[i]);
+        index.ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+
+        t = BenchClock::now();
+        std::shared_ptr<const DoctorView> view = system.getDoctorView("N1");
+        int start = parseSlotTime(from[i], today), next = -1;
+        for (const auto& day : view->days) {
+            if (day->day < slotDay(start)) continue;
+            for (const SlotView& s : day->slots) {
+                if (s.key >= start && s.booked < s.capacity) {
+                    next = s.key;
+                    break;
+                }
+            }
+            if (next >= 0) break;
+        }
+        scan.ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+        if (next < 0 ? !found.empty() : found != formatSlotTime(next)) mismatches++;
+    }
+    for (LatencySamples* s : {&index, &scan})
+        std::printf("  %-10s p50 %8.2f us  p99 %8.2f us\n", s->name, s->percentile(0.50) / 1000.0,
+                    s->percentile(0.99) / 1000.0);
+    if (mismatches) std::printf("  %zu answers differ\n", mismatches);
+
+    LatencySamples book{"book", {}};
+    size_t booked = 0;
+    long long minutesLater = 0;
+    for (int i = 0; i < queries; i++) {
+        BenchClock::time_point t = BenchClock::now();
+        AssignResult r = system.scheduleNearest(Patient("G" + std::to_string(i), "Name", 3), "N1", from[i]);
+        book.ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+        if (r.result.status == SCHEDULE_BOOKED) {
+            booked++;
+            minutesLater += parseSlotTime(r.timeSlot, today) - parseSlotTime(from[i], today);
+        }
+    }
+    std::printf("  scheduleNearest p50 %.2f us  p99 %.2f us, %zu booked, %.0f min after the asked time on average\n",
+                book.percentile(0.50) / 1000.0, book.percentile(0.99) / 1000.0, booked,
+                booked ? static_cast<double>(minutesLater) / booked : 0.0);
+}
+
+// A busy clinic day replayed on one doctor's call queue: `perDay` patients
+// arrive at random times over ten hours (their slot time is the arrival
+// time), mostly of low urgency, and the doctor calls the next one every
+// `service` minutes until the queue is empty. Waits, from slot time to
+// call, per priority level under a triage policy.
+static void simulateTriage(const char* name, const TriagePolicy& policy, int days, int perDay, int service) {
+    std::mt19937 rng(17);
+    std::discrete_distribution<int> levels({0, 5, 10, 20, 30, 35});
+    std::vector<LatencySamples> waits(6, LatencySamples{"", {}});
+    LatencySamples pops{"popNext", {}};
+    for (int d = 0; d < days; d++) {
+        int day = 20000 + d;
+        std::vector<TriageEntry> arrivals(perDay);
+        for (TriageEntry& e : arrivals) {
+            e = TriageEntry();
+            e.priorityLevel = levels(rng);
+            e.slotMinute = day * MINUTES_PER_DAY + 8 * 60 + static_cast<int>(rng() % 600);
+        }
+        std::sort(arrivals.begin(), arrivals.end(),
+                  [](const TriageEntry& a, const TriageEntry& b) { return a.slotMinute < b.slotMinute; });
+        for (int i = 0; i < perDay; i++) arrivals[i].order = i;
+
+        // A called patient's other heap copy is dead, as a called booking is.
+        std::vector<char> called(perDay, 0);
+        auto live = [&called](const TriageEntry& e) { return !called[e.order]; };
+        TriageQueue queue(std::vector<TriageEntry>(), policy);
+        int clock = day * MINUTES_PER_DAY + 8 * 60, next = 0, served = 0;
+        while (served < perDay) {
+            while (next < perDay && arrivals[next].slotMinute <= clock) queue.push(arrivals[next++]);
+            TriageEntry e;
+            int stale = 0;
+            BenchClock::time_point t = BenchClock::now();
+            bool found = queue.popNext(clock, day, live, e, stale);
+            pops.ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+            if (!found) {
+                clock = arrivals[next].slotMinute;
+                continue;
+            }
+            called[e.order] = 1;
+            waits[e.priorityLevel].ns.push_back(clock - e.slotMinute);
+            served++;
+            clock += service;
+        }
+    }
+    std::printf("  %s\n", name);
+    for (int level = 1; level <= 5; level++)
+        std::printf("    level %d  %6zu calls  wait min p50 %6.0f  p99 %6.0f  max %6.0f\n", level,
+                    waits[level].ns.size(), waits[level].percentile(0.50), waits[level].percentile(0.99),
+                    waits[level].percentile(1.0));
+    std::printf("    popNext p50 %.2f us  p99 %.2f us\n", pops.percentile(0.50) / 1000.0,
+                pops.percentile(0.99) / 1000.0);
+}
+
+// Aging against slots still ahead of the clock, which have waited 0: at
+// 10:00 with 30 min/level, a level-1 patient due at 15:00 goes before a
+// level-2 one waiting since 09:50, and a level-2 one due at 16:00 before a
+// level-3 one due at 11:00. Returns how many of the calls were in that order.
+static int checkFutureSlots() {
+    TriagePolicy aging;
+    aging.agingMinutes = 30;
+    int day = 20000, now = day * MINUTES_PER_DAY + 10 * 60;
+    struct Case { int level, minute; };
+    const Case cases[] = {{2, 9 * 60 + 50}, {1, 15 * 60}, {3, 11 * 60}, {2, 16 * 60}};
+    const int expected[] = {1, 0, 3, 2};
+    TriageQueue queue(std::vector<TriageEntry>(), aging);
+    std::vector<char> called(4, 0);
+    for (int i = 0; i < 4; i++)
+        queue.push({cases[i].level, 0, 0, 0, day * MINUTES_PER_DAY + cases[i].minute, i});
+    int right = 0;
+    for (int i = 0; i < 4; i++) {
+        TriageEntry e;
+        int stale = 0;
+        if (!queue.popNext(now, day, [&called](const TriageEntry& t) { return !called[t.order]; }, e, stale))
+            break;
+        called[e.order] = 1;
+        if (e.order == expected[i]) right++;
+    }
+    return right;
+}
+
+// The same simulated days under the static rule, a wait limit on the least
+// urgent level, aging, and both.
+static void benchTriage(int days, int perDay) {
+    int service = std::max(1, 600 * 95 / 100 / perDay); // the doctor is busy ~95% of the day
+    std::printf("triage: %d days, %d patients a day over 10 h, one called every %d min\n", days, perDay, service);
+    TriagePolicy limit, aging, both;
+    limit.maxWaitMinutes = {0, 0, 0, 0, 0, 90};
+    aging.agingMinutes = 30;
+    both = aging;
+    both.maxWaitMinutes = limit.maxWaitMinutes;
+    simulateTriage("static priority", TriagePolicy(), days, perDay, service);
+    simulateTriage("level 5 limited to 90 min", limit, days, perDay, service);
+    simulateTriage("aging 30 min/level", aging, days, perDay, service);
+    simulateTriage("aging + level 5 limit", both, days, perDay, service);
+    std::printf("  future slots: %d of 4 called in aged order\n", checkFutureSlots());
+}
+
+// 50 doctors, slots from 08:00, three requests per slot so every third one
+// lands on the waiting list.
+static std::vector<ScheduleRequest> importRequests(int count) {
+    std::vector<ScheduleRequest> batch;
+    batch.reserve(count);
+    for (int i = 0; i < count; i++) {
+        batch.push_back({Patient("R" + std::to_string(i), "Referral", i % 5 + 1),
+                         "I" + std::to_string(i % 50), slotName(8 * 60 + (i / 150) % 600)});
+    }
+    return batch;
+}
+
+// Weekday clinics, Mon-Fri 09:00-17:00 every 15 minutes with
+// four places, set up once as explicit slots and once as availability rules
+// with the same bookings made on top.
+static void benchAvailability(int doctorCount, int days, int bookings) {
+    AvailabilityRule rule{0x1F, 9 * 60, 17 * 60, 15, 4};
+    for (int mode = 0; mode < 2; mode++) {
+        removeSystemFiles();
+        size_t before = heapInUse();
+        HospitalSystem system;
+        int today = system.getToday();
+        size_t slots = 0;
+        for (int d = 0; d < doctorCount; d++) {
+            Doctor doctor("V" + std::to_string(d), "Doctor", "General");
+            if (mode == 1) {
+                doctor.addAvailability(rule);
+            } else {
+                for (int day = today; day < today + days; day++) {
+                    for (int m = rule.firstFrom(day, 0); m >= 0; m = rule.firstFrom(day, m + 1)) {
+                        doctor.addTimeSlot(day * MINUTES_PER_DAY + m, rule.capacity);
+                        slots++;
+                    }
+                }
+            }
+            system.addDoctor(doctor);
+        }
+        std::mt19937 rng(5);
+        LatencySamples samples{"assign", {}};
+        for (int i = 0; i < bookings; i++) {
+            int day = today + static_cast<int>(rng() % days);
+            std::string from = formatDate(day) + "T" + formatClock(8 * 60 + static_cast<int>(rng() % 600));
+            BenchClock::time_point t = BenchClock::now();
+            system.scheduleBySpecialty(Patient("B" + std::to_string(i), "Name", i % 5 + 1), "General", from);
+            samples.ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+        }
+        size_t held = heapInUse() - before;
+        if (mode == 0)
+            std::printf("availability: %d doctors x %d days, %d auto-assigned bookings\n", doctorCount, days,
+                        bookings);
+        std::printf("  %-19s heap %7.1f MiB  assign p50 %.1f us p99 %.1f us%s\n",
+                    mode == 0 ? "explicit slots" : "availability rules", held / (1024.0 * 1024.0),
+                    samples.percentile(0.50) / 1000.0, samples.percentile(0.99) / 1000.0,
+                    mode == 0 ? (" (" + std::to_string(slots) + " slots)").c_str() : "");
+    }
+}
+
+static void benchImport(int count) {
+    std::vector<ScheduleRequest> batch = importRequests(count);
+    double single = 0, bulk = 0;
+    size_t booked = 0;
+    for (int mode = 0; mode < 2; mode++) {
+        removeSystemFiles();
+        HospitalSystem system;
+        for (int d = 0; d < 50; d++)
+            system.addDoctor(Doctor("I" + std::to_string(d), "Import", "General"));
+
+        BenchClock::time_point start = BenchClock::now();
+        if (mode == 0) {
+            for (const ScheduleRequest& r : batch)
+                system.scheduleAppointment(r.patient, r.doctorID, r.timeSlot);
+            single = elapsedMs(start);
+        } else {
+            std::vector<ScheduleResult> results = system.scheduleAppointments(batch);
+            bulk = elapsedMs(start);
+            for (const ScheduleResult& r : results)
+                if (r.status == SCHEDULE_BOOKED) booked++;
+        }
+    }
+    std::printf("import: %d referrals\n", count);
+    std::printf("  %-22s %10.1f ms\n", "one call per item", single);
+    std::printf("  %-22s %10.1f ms  (%.2fx, %zu booked)\n", "scheduleAppointments", bulk,
+                 single / bulk, booked);
+}
+
+// listDoctors renders to std::cout; the workload swallows it.
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int ch) override { return ch; }
+};
+
+struct WorkloadConfig {
+    int doctors, slots, ops;
+    int schedule, cancel, call, list; // relative weights of the operation mix
+    unsigned seed;
+};
+
+static void benchWorkload(const WorkloadConfig& cfg) {
+    removeSystemFiles();
+    std::printf("workload: %d doctors x %d slots, %d ops (schedule %d / cancel %d / call %d / list %d)\n",
+                cfg.doctors, cfg.slots, cfg.ops, cfg.schedule, cfg.cancel, cfg.call, cfg.list);
+
+    std::mt19937 rng(cfg.seed);
+    std::discrete_distribution<int> opMix({double(cfg.schedule), double(cfg.cancel),
+                                           double(cfg.call), double(cfg.list)});
+    // Few urgent patients, many routine ones: level k is twice as likely as
+    // level k-1.
+    std::discrete_distribution<int> priority({1, 2, 4, 8, 16});
+    // Popular doctors and morning slots get more requests (quadratic skew).
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    auto skewed = [&](int n) { double u = unit(rng); return std::min(n - 1, static_cast<int>(u * u * n)); };
+
+    std::vector<std::string> doctorIDs, slotNames;
+    for (int d = 0; d < cfg.doctors; d++) doctorIDs.push_back("W" + std::to_string(d));
+    for (int m = 0; m < cfg.slots; m++) slotNames.push_back(slotName((8 * 60 + m * 5) % MINUTES_PER_DAY));
+
+    // Patients believed to hold a place, for cancellations; an entry that was
+    // called or is still waiting just makes the cancel a miss.
+    struct Held { int doctor, slot; std::string patientID; };
+    std::vector<Held> held;
+
+    LatencySamples samples[4] = {{"schedule", {}}, {"cancel", {}}, {"call", {}}, {"listDoctors", {}}};
+    NullBuffer nullBuffer;
+    std::streambuf* console = std::cout.rdbuf(&nullBuffer);
+    double totalMs;
+    {
+        HospitalSystem system;
+        for (int d = 0; d < cfg.doctors; d++)
+            system.addDoctor(Doctor(doctorIDs[d], "Doctor", "Specialty" + std::to_string(d % 12)));
+
+        int nextPatient = 0;
+        BenchClock::time_point start = BenchClock::now();
+        for (int i = 0; i < cfg.ops; i++) {
+            int op = opMix(rng);
+            if (op == 1 && held.empty()) op = 0;
+            BenchClock::time_point t = BenchClock::now();
+            if (op == 0) {
+                int d = skewed(cfg.doctors), m = skewed(cfg.slots);
+                std::string patientID = "Q" + std::to_string(nextPatient++);
+                ScheduleResult r = system.scheduleAppointment(Patient(patientID, "Name", priority(rng) + 1),
+                                                              doctorIDs[d], slotNames[m]);
+                samples[0].ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+                if (r.status == SCHEDULE_BOOKED) held.push_back({d, m, patientID});
+            } else if (op == 1) {
+                size_t k = rng() % held.size();
+                system.cancelAppointment(doctorIDs[held[k].doctor], slotNames[held[k].slot], held[k].patientID);
+                samples[1].ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+                held[k] = held.back();
+                held.pop_back();
+            } else if (op == 2) {
+                system.callNextPatient(doctorIDs[skewed(cfg.doctors)]);
+                samples[2].ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+            } else {
+                system.listDoctors();
+                samples[3].ns.push_back(std::chrono::duration<double, std::nano>(BenchClock::now() - t).count());
+            }
+        }
+        totalMs = elapsedMs(start);
+    }
+    std::cout.rdbuf(console);
+
+    std::printf("  %-12s %10s %12s %12s %12s\n", "operation", "count", "ops/s", "p50 us", "p99 us");
+    for (LatencySamples& s : samples) {
+        double sumNs = 0;
+        for (double ns : s.ns) sumNs += ns;
+        std::printf("  %-12s %10zu %12.0f %12.2f %12.2f\n", s.name, s.ns.size(),
+                    sumNs > 0 ? s.ns.size() / (sumNs / 1e9) : 0.0,
+                    s.percentile(0.50) / 1000.0, s.percentile(0.99) / 1000.0);
+    }
+    std::printf("  %-12s %10d %12.0f\n", "all", cfg.ops, cfg.ops / (totalMs / 1000.0));
+
+    // Restart on what the workload left behind: doctors.txt plus the journal,
+    // or the snapshot if compaction ran.
+    BenchClock::time_point start = BenchClock::now();
+    {
+        HospitalSystem system;
+    }
+    std::printf("  reload %.1f ms, peak RSS %.1f MiB\n", elapsedMs(start), peakRssMb());
+}
+
+// The same front-desk day replayed through runMenu (menu choices on a
+// redirected std::cin, prompts swallowed) and through runCommands.
+static void benchCommands(int ops) {
+    const int doctorCount = 200, slots = 96;
+    std::mt19937 rng(3);
+    std::ostringstream menu, commands;
+    for (int d = 0; d < doctorCount; d++) {
+        menu << "1\nC" << d << " Doctor General\n";
+        commands << "D C" << d << " Doctor General\n";
+    }
+    std::vector<std::string> placed;
+    for (int i = 0; i < ops; i++) {
+        unsigned op = rng() % 100;
+        std::string doctor = "C" + std::to_string(rng() % doctorCount);
+        if (op < 70 || placed.empty()) {
+            std::string patient = "R" + std::to_string(i);
+            std::string line = patient + " Name " + std::to_string(rng() % 5 + 1) + " " + doctor + " " +
+                               slotName(8 * 60 + static_cast<int>(rng() % slots) * 5);
+            menu << "4\n" << line << "\n";
+            commands << "S " << line << "\n";
+            placed.push_back(doctor + " " + line.substr(line.rfind(' ') + 1) + " " + patient);
+        } else if (op < 85) {
+            size_t k = rng() % placed.size();
+            menu << "5\n" << placed[k] << "\n";
+            commands << "X " << placed[k] << "\n";
+            placed[k] = placed.back();
+            placed.pop_back();
+        } else {
+            menu << "6\n" << doctor << "\n";
+            commands << "C " << doctor << "\n";
+        }
+    }
+    menu << "0\n";
+    std::printf("commands: %d operations on %d doctors\n", ops, doctorCount);
+
+    NullBuffer nullBuffer;
+    for (int mode = 0; mode < 2; mode++) {
+        removeSystemFiles();
+        std::istringstream in(mode == 0 ? menu.str() : commands.str());
+        std::ostream discard(&nullBuffer);
+        BenchClock::time_point start;
+        double ms;
+        int booked;
+        {
+            HospitalSystem system;
+            start = BenchClock::now();
+            if (mode == 0) {
+                std::streambuf* keyboard = std::cin.rdbuf(in.rdbuf());
+                std::streambuf* console = std::cout.rdbuf(&nullBuffer);
+                system.runMenu();
+                std::cin.rdbuf(keyboard);
+                std::cout.rdbuf(console);
+            } else {
+                system.runCommands(in, discard);
+            }
+            ms = elapsedMs(start);
+            booked = system.getSpecialtyLoads()["General"].booked;
+        }
+        std::printf("  %-9s %8.1f ms  %10.0f ops/s  (%d booked at the end)\n",
+                    mode == 0 ? "runMenu" : "commands", ms, ops / (ms / 1000.0), booked);
+    }
+}
+
+// A schedule/cancel/call mix run without a sink and with the history
+// exporter, then one streaming pass over the chunks it wrote.
+static void benchHistory(int ops) {
+    const int doctorCount = 200, slots = 96;
+    std::printf("history: %d operations on %d doctors\n", ops, doctorCount);
+    for (int mode = 0; mode < 2; mode++) {
+        removeSystemFiles();
+        std::mt19937 rng(5);
+        std::vector<std::string> placed; // "doctor slot patient"
+        HistoryExporter exporter("history", 100000);
+        double ms;
+        {
+            // Slots of yesterday, so every call comes after its slot time
+            // and the read-back below has waits to average.
+            HospitalSystem system(currentDay() - 1);
+            for (int d = 0; d < doctorCount; d++)
+                system.addDoctor(Doctor("H" + std::to_string(d), "Doctor", "General"));
+            if (mode == 1) system.setEventSink(&exporter);
+            BenchClock::time_point start = BenchClock::now();
+            for (int i = 0; i < ops; i++) {
+                unsigned op = rng() % 100;
+                std::string doctor = "H" + std::to_string(rng() % doctorCount);
+                if (op < 65 || placed.empty()) {
+                    std::string patient = "R" + std::to_string(i);
+                    std::string slot = slotName(8 * 60 + static_cast<int>(rng() % slots) * 5);
+                    ScheduleResult r = system.scheduleAppointment(Patient(patient, "Name", rng() % 5 + 1),
+                                                                  doctor, slot);
+                    if (r.status == SCHEDULE_BOOKED) placed.push_back(doctor + " " + slot + " " + patient);
+                } else if (op < 80) {
+                    size_t k = rng() % placed.size();
+                    std::istringstream fields(placed[k]);
+                    std::string d, slot, patient;
+                    fields >> d >> slot >> patient;
+                    system.cancelAppointment(d, slot, patient);
+                    placed[k] = placed.back();
+                    placed.pop_back();
+                } else {
+                    system.callNextPatient(doctor);
+                }
+            }
+            ms = elapsedMs(start);
+            system.setEventSink(nullptr);
+        }
+        // The writer thread may still hold queued rows; their time is
+        // reported apart.
+        BenchClock::time_point closing = BenchClock::now();
+        exporter.close();
+        double closeMs = elapsedMs(closing);
+        if (mode == 0) {
+            std::printf("  %-9s %8.1f ms  %10.0f ops/s\n", "no sink", ms, ops / (ms / 1000.0));
+            continue;
+        }
+        size_t rows = exporter.rowCount();
+        std::printf("  %-9s %8.1f ms  %10.0f ops/s  %zu rows, %.1f bytes per row, drained in %.1f ms\n",
+                    "exporter", ms, ops / (ms / 1000.0), rows,
+                    rows ? static_cast<double>(exporter.byteCount()) / rows : 0.0, closeMs);
+
+        // Reading back: per event counts and mean wait until called by
+        // priority, one mapped chunk at a time.
+        size_t before = heapInUse();
+        std::map<std::string, size_t> events;
+        long long waitSum[6] = {0};
+        size_t waitCount[6] = {0};
+        BenchClock::time_point start = BenchClock::now();
+        forEachHistoryRow("history", [&](const HistoryRow& r) {
+            events[std::string(r.event)]++;
+            if (r.event == "called" && r.waitMs >= 0 && r.priorityLevel >= 1 && r.priorityLevel <= 5) {
+                waitSum[r.priorityLevel] += r.waitMs;
+                waitCount[r.priorityLevel]++;
+            }
+        });
+        double readMs = elapsedMs(start);
+        std::printf("  read back %.1f ms (%.0f rows/s), heap grew %.1f KiB:",
+                    readMs, rows / (readMs / 1000.0), (heapInUse() - before) / 1024.0);
+        for (const auto& e : events) std::printf(" %s %zu", e.first.c_str(), e.second);
+        std::printf("\n  mean wait past the slot time when called, ms:");
+        for (int p = 1; p <= 5; p++)
+            std::printf(" p%d %.2f", p, waitCount[p] ? static_cast<double>(waitSum[p]) / waitCount[p] : 0.0);
+        std::printf("\n");
+    }
+}
+
+// The socket server on a Unix socket, in a thread of this process, under the
+// load generator of CommandClient.h: one command in flight per connection,
+// then `depth` pipelined.
+static void benchServer(int requests, int connections, int depth) {
+    std::printf("server: %d commands over %d connections (Unix socket)\n", requests, connections);
+    for (int d : {1, depth}) {
+        removeSystemFiles();
+        HospitalSystem system;
+        CommandServer server(system);
+        if (!server.listenUnix("bench.sock")) {
+            std::printf("  cannot listen on bench.sock\n");
+            return;
+        }
+        std::thread loop([&server] { server.run(); });
+        LoadConfig cfg;
+        cfg.requests = requests;
+        cfg.connections = connections;
+        cfg.depth = d;
+        LoadReport report;
+        bool ok = runLoad("bench.sock", cfg, report);
+        server.stop();
+        loop.join();
+        if (!ok) {
+            std::printf("  depth %d: connection failed\n", d);
+            continue;
+        }
+        std::printf("  depth %-3d %10.0f commands/s  p50 %8.1f us  p99 %8.1f us  p99.9 %8.1f us\n", d,
+                    report.requests / report.seconds, report.percentile(0.50), report.percentile(0.99),
+                    report.percentile(0.999));
+    }
+}
+
+static int intOption(const std::map<std::string, std::string>& options, const char* key, int fallback) {
+    auto it = options.find(key);
+    return it == options.end() ? fallback : std::atoi(it->second.c_str());
+}
+
+int main(int argc, char** argv) {
+    std::set<std::string> sections;
+    std::map<std::string, std::string> options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos)
+            sections.insert(arg);
+        else
+            options[arg.substr(0, eq)] = arg.substr(eq + 1);
+    }
+    auto wanted = [&sections](const char* name) { return sections.empty() || sections.count(name) != 0; };
+
+    WorkloadConfig workload;
+    workload.doctors = intOption(options, "doctors", 200);
+    workload.slots = std::min(intOption(options, "slots", 96), MINUTES_PER_DAY / 5);
+    workload.ops = intOption(options, "ops", 500000);
+    workload.schedule = intOption(options, "schedule", 60);
+    workload.cancel = intOption(options, "cancel", 20);
+    workload.call = intOption(options, "call", 15);
+    workload.list = intOption(options, "list", 5);
+    workload.seed = intOption(options, "seed", 1);
+
+    // HospitalSystem reads and writes its files in the working directory.
+    char scratch[] = "/tmp/hospital_bench_XXXXXX";
+    if (!mkdtemp(scratch) || chdir(scratch) != 0) {
+        std::perror("scratch directory");
+        return 1;
+    }
+
+    // HospitalSystem reports through its event sink, silent unless one is
+    // set, so none of the sections do console I/O per operation.
+    bool ok = true;
+    if (wanted("loader")) benchLoaders(intOption(options, "lines", 1000000), 3);
+    if (wanted("import")) benchImport(intOption(options, "referrals", 100000));
+    if (wanted("memory")) benchMemory(intOption(options, "bookings", 1000000));
+    if (wanted("days")) benchDays(intOption(options, "pastDays", 30), intOption(options, "perDay", 20000));
+    if (wanted("nearest")) benchNearest(intOption(options, "nearestDays", 365), intOption(options, "nearestQueries", 5000));
+    if (wanted("triage")) benchTriage(intOption(options, "triageDays", 200), intOption(options, "triagePatients", 110));
+    if (wanted("availability"))
+        benchAvailability(intOption(options, "availabilityDoctors", 200), 90, intOption(options, "availabilityBookings", 20000));
+    if (wanted("workload")) benchWorkload(workload);
+    if (wanted("commands")) benchCommands(intOption(options, "commandOps", 200000));
+    if (wanted("history")) benchHistory(intOption(options, "historyOps", 200000));
+    if (wanted("server"))
+        benchServer(intOption(options, "serverOps", 100000), intOption(options, "connections", 4),
+                    intOption(options, "depth", 16));
+    if (wanted("assign"))
+        benchAssign(intOption(options, "assignDoctors", 5000), 32, intOption(options, "assignRequests", 20000));
+    if (wanted("stress")) ok = stressSharedDoctors(intOption(options, "threads", 8), 20000);
+    if (wanted("throughput")) benchThroughput(50000);
+    if (wanted("reports"))
+        benchReports(intOption(options, "reportOps", 200000),
+                     intOption(options, "readers", std::max(1u, std::thread::hardware_concurrency() - 1)));
+    std::fflush(stdout);
+
+    removeSystemFiles();
+    if (chdir("/") == 0) rmdir(scratch);
+    return ok ? 0 : 1;
+}
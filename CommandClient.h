@@ -0,0 +1,249 @@
+#ifndef COMMANDCLIENT_H
+#define COMMANDCLIENT_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Client side of CommandServer: connecting, and a pipelined load generator
+// for measuring the server's throughput and latency on this host.
+
+// Connects to "7000" (127.0.0.1, TCP) or a Unix socket path; -1 on failure.
+inline int connectCommandServer(const std::string& address){
+    int fd;
+    if(!address.empty() && address.find_first_not_of("0123456789") == std::string::npos){
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof addr);
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(std::atoi(address.c_str())));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd < 0) return -1;
+        if(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0){
+            ::close(fd);
+            return -1;
+        };
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        return fd;
+    };
+    sockaddr_un addr;
+    std::memset(&addr, 0, sizeof addr);
+    if(address.size() >= sizeof addr.sun_path) return -1;
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, address.c_str(), address.size() + 1);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(fd < 0) return -1;
+    if(connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0){
+        ::close(fd);
+        return -1;
+    };
+    return fd;
+}
+
+// Sends `lines` and reads until one response line per command came back;
+// false if the connection broke. For setup, not for measuring.
+inline bool exchangeCommands(int fd, const std::string& lines, size_t commands, std::string& responses){
+    for(size_t sent = 0; sent < lines.size(); ){
+        ssize_t n = ::send(fd, lines.data() + sent, lines.size() - sent, MSG_NOSIGNAL);
+        if(n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    };
+    size_t seen = 0;
+    char buffer[16 * 1024];
+    while(seen < commands){
+        ssize_t n = ::read(fd, buffer, sizeof buffer);
+        if(n <= 0) return false;
+        responses.append(buffer, static_cast<size_t>(n));
+        seen += std::count(buffer, buffer + n, '\n');
+    };
+    return true;
+}
+
+struct LoadConfig{
+    int connections = 4;
+    int depth = 16;          // commands in flight per connection
+    int requests = 100000;   // in total, spread over the connections
+    int doctors = 200;       // D1..Dn, added before the run
+    int slots = 96;          // five-minute slots from 08:00
+    int schedule = 60, cancel = 15, call = 20, list = 5; // command mix weights
+    unsigned seed = 1;
+};
+
+struct LoadReport{
+    size_t requests = 0;
+    size_t errors = 0;       // ERROR responses
+    double seconds = 0;
+    std::vector<float> latencyUs; // per command, send to response
+
+    double percentile(double p){
+        if(latencyUs.empty()) return 0;
+        size_t k = std::min(latencyUs.size() - 1, static_cast<size_t>(p * latencyUs.size()));
+        std::nth_element(latencyUs.begin(), latencyUs.begin() + k, latencyUs.end());
+        return latencyUs[k];
+    };
+};
+
+// Front-desk traffic against a running server: `connections` clients each
+// keep `depth` commands in flight, drawn from the schedule/cancel/call/list
+// mix (cancellations are of that client's own bookings). Latency runs from
+// the moment a command is queued for sending to its response, so it
+// includes waiting behind the commands ahead of it. False if a connection
+// could not be made or broke.
+inline bool runLoad(const std::string& address, const LoadConfig& cfg, LoadReport& report){
+    typedef std::chrono::steady_clock Clock;
+    struct Pending{
+        Clock::time_point sent;
+        std::string booking; // "doctor slot patient" for a schedule command
+    };
+    struct Client{
+        int fd;
+        std::mt19937 rng;
+        int quota, issued = 0, answered = 0;
+        std::string out, in;
+        size_t outSent = 0;
+        std::deque<Pending> pending;
+        std::vector<std::string> booked;
+    };
+
+    std::string setup;
+    for(int d = 1; d <= cfg.doctors; d++) setup += "D D" + std::to_string(d) + " Doctor General\n";
+    int setupFd = connectCommandServer(address);
+    std::string ignored;
+    bool ok = setupFd >= 0 && exchangeCommands(setupFd, setup, cfg.doctors, ignored);
+    if(setupFd >= 0) ::close(setupFd);
+    if(!ok) return false;
+
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    std::vector<Client> clients(cfg.connections);
+    for(int i = 0; i < cfg.connections; i++){
+        Client& c = clients[i];
+        c.fd = connectCommandServer(address);
+        c.rng.seed(cfg.seed * 7919 + i);
+        c.quota = cfg.requests / cfg.connections + (i < cfg.requests % cfg.connections ? 1 : 0);
+        if(c.fd < 0) ok = false;
+        else fcntl(c.fd, F_SETFL, fcntl(c.fd, F_GETFL) | O_NONBLOCK);
+    };
+    if(!ok || epoll < 0){
+        for(Client& c : clients) if(c.fd >= 0) ::close(c.fd);
+        if(epoll >= 0) ::close(epoll);
+        return false;
+    };
+
+    std::discrete_distribution<int> mix({double(cfg.schedule), double(cfg.cancel), double(cfg.call), double(cfg.list)});
+    auto issue = [&](Client& c, int index){
+        Pending p;
+        int op = mix(c.rng);
+        if(op == 1 && c.booked.empty()) op = 0;
+        std::string doctor = "D" + std::to_string(c.rng() % cfg.doctors + 1);
+        if(op == 0){
+            int minute = 8 * 60 + static_cast<int>(c.rng() % cfg.slots) * 5;
+            char slot[8];
+            std::snprintf(slot, sizeof slot, "%02d:%02d", minute / 60 % 24, minute % 60);
+            std::string patient = "L" + std::to_string(index) + "_" + std::to_string(c.issued);
+            c.out += "S " + patient + " Name " + std::to_string(c.rng() % 5 + 1) + " " + doctor + " " + slot + "\n";
+            p.booking = doctor + " " + slot + " " + patient;
+        }else if(op == 1){
+            size_t k = c.rng() % c.booked.size();
+            c.out += "X " + c.booked[k] + "\n";
+            c.booked[k] = c.booked.back();
+            c.booked.pop_back();
+        }else if(op == 2){
+            c.out += "C " + doctor + "\n";
+        }else{
+            c.out += "L\n";
+        };
+        p.sent = Clock::now();
+        c.pending.push_back(std::move(p));
+        c.issued++;
+    };
+    // Tops the client up to `depth` in flight and sends what the socket takes.
+    auto pump = [&](Client& c, int index){
+        while(c.issued < c.quota && static_cast<int>(c.pending.size()) < cfg.depth) issue(c, index);
+        while(c.outSent < c.out.size()){
+            ssize_t n = ::send(c.fd, c.out.data() + c.outSent, c.out.size() - c.outSent, MSG_NOSIGNAL);
+            if(n < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+            c.outSent += static_cast<size_t>(n);
+        };
+        c.out.clear();
+        c.outSent = 0;
+        return true;
+    };
+
+    report = LoadReport();
+    report.latencyUs.reserve(cfg.requests);
+    Clock::time_point start = Clock::now();
+    int open = 0;
+    for(int i = 0; i < cfg.connections; i++){
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof ev);
+        ev.events = EPOLLIN;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(epoll, EPOLL_CTL_ADD, clients[i].fd, &ev);
+        if(clients[i].quota > 0){
+            ok = pump(clients[i], i) && ok;
+            open++;
+        };
+    };
+
+    std::vector<epoll_event> ready(64);
+    char buffer[64 * 1024];
+    while(ok && open > 0){
+        int n = epoll_wait(epoll, ready.data(), static_cast<int>(ready.size()), 1000);
+        if(n < 0 && errno != EINTR) ok = false;
+        // Nothing came back for a second: retry sends the socket refused.
+        for(int i = 0; ok && n == 0 && i < cfg.connections; i++){
+            if(clients[i].answered < clients[i].quota) ok = pump(clients[i], i);
+        };
+        for(int i = 0; ok && i < n; i++){
+            int index = static_cast<int>(ready[i].data.u32);
+            Client& c = clients[index];
+            ssize_t got = ::read(c.fd, buffer, sizeof buffer);
+            if(got <= 0){
+                ok = got < 0 && (errno == EAGAIN || errno == EINTR);
+                continue;
+            };
+            c.in.append(buffer, static_cast<size_t>(got));
+            Clock::time_point now = Clock::now();
+            size_t begin = 0, end;
+            while((end = c.in.find('\n', begin)) != std::string::npos){
+                std::string_view line(c.in.data() + begin, end - begin);
+                begin = end + 1;
+                if(c.pending.empty()){
+                    ok = false; // more answers than commands
+                    break;
+                };
+                Pending& p = c.pending.front();
+                report.latencyUs.push_back(std::chrono::duration<float, std::micro>(now - p.sent).count());
+                if(!p.booking.empty() && line == "BOOKED") c.booked.push_back(std::move(p.booking));
+                if(line.compare(0, 5, "ERROR") == 0) report.errors++;
+                c.pending.pop_front();
+                c.answered++;
+            };
+            c.in.erase(0, begin);
+            if(c.answered == c.quota) open--;
+            else ok = pump(c, index) && ok;
+        };
+    };
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    report.requests = report.latencyUs.size();
+    for(Client& c : clients) ::close(c.fd);
+    ::close(epoll);
+    return ok;
+}
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef COMMANDSERVER_H
+#define COMMANDSERVER_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "HospitalSystem.h"
+
+// Socket front end: the command stream of CommandStream.h over TCP on the
+// loopback interface or over a Unix socket, for front-desk clients on the
+// same host. One thread runs an epoll loop over every connection.
+//
+// Clients may pipeline: send any number of command lines without waiting,
+// and read the responses, one line per command, in the same order. Each
+// wakeup of the loop reads what every ready connection sent, runs all its
+// complete lines as one journal group commit (HospitalSystem::
+// beginCommandBatch) and only then queues the responses, so an answer is
+// never sent before its booking is on disk. Connections are served in the
+// order epoll reports them; one connection's commands always run in order.
+//
+// Every connection has its own input buffer (a partial line waits there for
+// the rest) and output buffer (what the socket would not take yet). A client
+// that sends without reading is not read from again until it has taken all
+// but outputLimit bytes of its responses.
+//
+// epoll reports a connection by its key, not its fd: the fd with a serial
+// number above it. A connection closed early in a batch can have its fd
+// handed to one accepted later in the same batch, and the closed one's
+// remaining events then find no connection instead of the new one.
+class CommandServer{
+    private:
+        struct Connection{
+            int fd = -1;
+            uint64_t key = 0;     // serial << 32 | fd, as epoll reports it
+            std::string in;
+            std::string out;
+            size_t sent = 0;      // bytes of out already written
+            bool reading = true;  // watched for EPOLLIN
+            bool writing = false; // watched for EPOLLOUT
+            bool eof = false;     // peer finished sending
+        };
+
+        HospitalSystem& system;
+        int epoll;
+        int wakeRead, wakeWrite; // self-pipe for stop()
+        std::vector<int> listeners;
+        std::vector<std::string> socketPaths; // unlinked when the server closes
+        std::unordered_map<uint64_t, Connection> connections; // by key
+        uint64_t serial;      // of the last connection accepted
+        size_t outputLimit;
+        size_t lineLimit;
+        size_t commandCount;
+        size_t acceptedCount;
+
+        static const size_t READ_CHUNK = 64 * 1024;
+
+        // Listeners and the wake pipe are reported by their bare fd.
+        void watch(int fd, uint64_t key, uint32_t events, int op){
+            epoll_event ev;
+            std::memset(&ev, 0, sizeof ev);
+            ev.events = events;
+            ev.data.u64 = key;
+            epoll_ctl(epoll, op, fd, &ev);
+        };
+        bool addListener(int fd){
+            if(fd < 0) return false;
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            if(listen(fd, 128) != 0){
+                ::close(fd);
+                return false;
+            };
+            listeners.push_back(fd);
+            watch(fd, static_cast<uint64_t>(fd), EPOLLIN, EPOLL_CTL_ADD);
+            return true;
+        };
+        bool isListener(int fd) const{
+            for(int l : listeners){
+                if(l == fd) return true;
+            };
+            return false;
+        };
+        void acceptAll(int listener){
+            while(true){
+                int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if(fd < 0) return;
+                int one = 1;
+                setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one); // fails harmlessly on Unix sockets
+                uint64_t key = ++serial << 32 | static_cast<uint32_t>(fd);
+                Connection& c = connections[key];
+                c.fd = fd;
+                c.key = key;
+                watch(fd, key, EPOLLIN | EPOLLRDHUP, EPOLL_CTL_ADD);
+                acceptedCount++;
+            };
+        };
+        void drop(const Connection& c){
+            epoll_ctl(epoll, EPOLL_CTL_DEL, c.fd, nullptr);
+            ::close(c.fd);
+            connections.erase(c.key);
+        };
+        // Reads once from the peer (the loop is level-triggered, so more
+        // waiting input wakes it again after the others had their turn) and
+        // runs the complete lines; false if the connection broke. Called
+        // inside the loop's command batch.
+        bool readAndRun(Connection& c){
+            char buffer[READ_CHUNK];
+            ssize_t n = ::read(c.fd, buffer, sizeof buffer);
+            if(n > 0) c.in.append(buffer, static_cast<size_t>(n));
+            else if(n == 0) c.eof = true;
+            else if(errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) return false;
+
+            std::string_view input(c.in);
+            commandCount += system.runCommandLines(input, c.out, c.eof);
+            c.in.erase(0, c.in.size() - input.size());
+            // A line that never ends is not a command.
+            return c.in.size() <= lineLimit;
+        };
+        // Writes what the socket takes; false if the connection broke.
+        bool writePending(Connection& c){
+            while(c.sent < c.out.size()){
+                ssize_t n = ::send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+                if(n < 0){
+                    if(errno == EINTR) continue;
+                    if(errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    return false;
+                };
+                c.sent += static_cast<size_t>(n);
+            };
+            if(c.sent == c.out.size()){
+                c.out.clear();
+                c.sent = 0;
+            };
+            return true;
+        };
+        // After a write: keep the connection, or close it (peer done and
+        // everything answered); adjusts what it is watched for.
+        void settle(Connection& c){
+            bool writing = c.sent < c.out.size();
+            if(c.eof && !writing){
+                drop(c);
+                return;
+            };
+            bool reading = !c.eof && c.out.size() - c.sent <= outputLimit;
+            if(reading == c.reading && writing == c.writing) return;
+            uint32_t events = 0;
+            if(reading) events |= EPOLLIN | EPOLLRDHUP;
+            if(writing) events |= EPOLLOUT;
+            watch(c.fd, c.key, events, EPOLL_CTL_MOD);
+            c.reading = reading;
+            c.writing = writing;
+        };
+    public:
+        explicit CommandServer(HospitalSystem& s, size_t maxPendingOutput = 4 << 20, size_t maxLine = 64 * 1024)
+        : system(s), epoll(epoll_create1(EPOLL_CLOEXEC)), wakeRead(-1), wakeWrite(-1),
+          serial(0), outputLimit(maxPendingOutput), lineLimit(maxLine), commandCount(0), acceptedCount(0) {
+            int fds[2];
+            if(pipe2(fds, O_NONBLOCK | O_CLOEXEC) == 0){
+                wakeRead = fds[0];
+                wakeWrite = fds[1];
+                watch(wakeRead, static_cast<uint64_t>(wakeRead), EPOLLIN, EPOLL_CTL_ADD);
+            };
+        };
+        CommandServer(const CommandServer&) = delete;
+        CommandServer& operator=(const CommandServer&) = delete;
+        ~CommandServer(){
+            for(auto& e : connections) ::close(e.second.fd);
+            for(int fd : listeners) ::close(fd);
+            for(const std::string& path : socketPaths) ::unlink(path.c_str());
+            if(wakeRead >= 0) ::close(wakeRead);
+            if(wakeWrite >= 0) ::close(wakeWrite);
+            if(epoll >= 0) ::close(epoll);
+        };
+
+        // Listens on 127.0.0.1:port (0 picks a free port; see tcpPort).
+        bool listenTcp(int port){
+            int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if(fd < 0) return false;
+            int one = 1;
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof addr);
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(static_cast<uint16_t>(port));
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            if(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0){
+                ::close(fd);
+                return false;
+            };
+            return addListener(fd);
+        };
+        // Listens on a Unix socket at path, replacing a stale socket file.
+        bool listenUnix(const std::string& path){
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof addr);
+            if(path.size() >= sizeof addr.sun_path) return false;
+            addr.sun_family = AF_UNIX;
+            std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+            int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+            if(fd < 0) return false;
+            ::unlink(path.c_str());
+            if(bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof addr) != 0){
+                ::close(fd);
+                return false;
+            };
+            socketPaths.push_back(path);
+            return addListener(fd);
+        };
+        // "7000" is a loopback TCP port, anything else a Unix socket path.
+        bool listenOn(const std::string& address){
+            if(!address.empty() && address.find_first_not_of("0123456789") == std::string::npos)
+                return listenTcp(std::atoi(address.c_str()));
+            return listenUnix(address);
+        };
+        // Port of the first TCP listener, or -1.
+        int tcpPort() const{
+            for(int fd : listeners){
+                sockaddr_in addr;
+                socklen_t len = sizeof addr;
+                if(getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len) == 0 && addr.sin_family == AF_INET)
+                    return ntohs(addr.sin_port);
+            };
+            return -1;
+        };
+
+        // Serves until stop(). Returns false if there was nothing to serve.
+        bool run(){
+            if(epoll < 0 || wakeRead < 0 || listeners.empty()) return false;
+            std::vector<epoll_event> ready(256);
+            std::vector<uint64_t> answered; // connection keys
+            while(true){
+                int n = epoll_wait(epoll, ready.data(), static_cast<int>(ready.size()), -1);
+                if(n < 0){
+                    if(errno == EINTR) continue;
+                    return false;
+                };
+                bool stopping = false;
+                answered.clear();
+                system.beginCommandBatch();
+                for(int i = 0; i < n; i++){
+                    uint64_t key = ready[i].data.u64;
+                    uint32_t events = ready[i].events;
+                    if(key == static_cast<uint64_t>(wakeRead)){
+                        stopping = true;
+                        continue;
+                    };
+                    if(key >> 32 == 0 && isListener(static_cast<int>(key))){
+                        acceptAll(static_cast<int>(key));
+                        continue;
+                    };
+                    // Gone: closed earlier in this batch, its fd maybe reused.
+                    auto it = connections.find(key);
+                    if(it == connections.end()) continue;
+                    Connection& c = it->second;
+                    if((events & EPOLLERR) || ((events & EPOLLHUP) && !(events & EPOLLIN))){
+                        drop(c);
+                        continue;
+                    };
+                    if((events & (EPOLLIN | EPOLLRDHUP)) && c.reading && !readAndRun(c)){
+                        drop(c);
+                        continue;
+                    };
+                    answered.push_back(key);
+                };
+                // The batch is durable now; answer it.
+                system.endCommandBatch();
+                for(uint64_t key : answered){
+                    auto it = connections.find(key);
+                    if(it == connections.end()) continue;
+                    if(!writePending(it->second)) drop(it->second);
+                    else settle(it->second);
+                };
+                if(stopping) return true;
+            };
+        };
+        // Makes run() return after the current batch; safe from a signal
+        // handler or another thread.
+        void stop(){
+            char byte = 0;
+            if(wakeWrite >= 0 && ::write(wakeWrite, &byte, 1) < 0) {};
+        };
+        size_t commandsServed() const { return commandCount; };
+        size_t connectionsAccepted() const { return acceptedCount; };
+        size_t connectionsOpen() const { return connections.size(); };
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef COMMANDSTREAM_H
+#define COMMANDSTREAM_H
+
+#include <string>
+#include <string_view>
+#include "HospitalStatus.h"
+#include "MappedFile.h" // nextToken, nextInt
+
+// Headless command stream read by HospitalSystem::runCommands: one command
+// per line, fields separated by spaces, the same fields the menu asks for.
+// Blank lines and lines starting with '#' are skipped. Every other line gets
+// exactly one response line, in input order:
+//
+//   D doctorID name specialty                 ADDED | EXISTS
+//   A doctorID days from to step capacity     ADDED | DOCTOR_NOT_FOUND | INVALID
+//   S patientID name priority doctorID time   <schedule status>
+//   B patientID name priority specialty from  BOOKED doctorID time | <schedule status>
+//   N patientID name priority doctorID from   BOOKED time | <schedule status>
+//   Q doctorID from                           NEXT time | NONE
+//   X doctorID time patientID                 CANCELLED | DOCTOR_NOT_FOUND | SLOT_NOT_FOUND | NOT_FOUND
+//   C doctorID                                CALLED patientID name priority time | <call status>
+//   F patientID                               FOUND n {doctorID time BOOKED|WAITING}
+//   L                                         DOCTORS n {doctorID name specialty booked}
+//   T YYYY-MM-DD                              DAY YYYY-MM-DD (today afterwards)
+//   anything else                             ERROR malformed
+//
+// A schedule status is BOOKED, WAITLISTED, WAITLIST_FULL, DOCTOR_NOT_FOUND,
+// INVALID_TIME, NOT_OFFERED, NO_FREE_SLOT, NAMES_FULL or
+// "ALREADY_BOOKED doctorID BOOKED|WAITING" naming where the patient is.
+enum CommandOp : char {
+    COMMAND_ADD_DOCTOR   = 'D',
+    COMMAND_AVAILABILITY = 'A',
+    COMMAND_SCHEDULE     = 'S',
+    COMMAND_ASSIGN       = 'B',
+    COMMAND_NEAREST      = 'N',
+    COMMAND_NEXT_FREE    = 'Q',
+    COMMAND_CANCEL       = 'X',
+    COMMAND_CALL         = 'C',
+    COMMAND_FIND         = 'F',
+    COMMAND_LIST         = 'L',
+    COMMAND_DAY          = 'T'
+};
+
+enum CommandParse {
+    COMMAND_OK,
+    COMMAND_SKIP,     // blank line or comment
+    COMMAND_MALFORMED
+};
+
+// One parsed line. The views point into the line, which must outlive the
+// command; which fields are set depends on op.
+struct Command{
+    CommandOp op;
+    std::string_view id;     // doctorID for D/A/X/C/Q, patientID for S/B/N/F
+    std::string_view name;   // doctor or patient name; days for A
+    std::string_view target; // specialty for D/B, doctorID for S/N, patientID for X
+    std::string_view time;   // slot for S/X, from for A/B/N/Q, date for T
+    std::string_view until;  // A only
+    int priority = 0;        // S/B/N; step for A
+    int capacity = 0;        // A only
+};
+
+inline CommandParse parseCommand(std::string_view line, Command& c){
+    std::string_view op;
+    if(!nextToken(line, op) || op[0] == '#') return COMMAND_SKIP;
+    if(op.size() != 1) return COMMAND_MALFORMED;
+    c.op = static_cast<CommandOp>(op[0]);
+    bool ok = false;
+    switch(c.op){
+        case COMMAND_ADD_DOCTOR:
+            ok = nextToken(line, c.id) && nextToken(line, c.name) && nextToken(line, c.target);
+            break;
+        case COMMAND_AVAILABILITY:
+            ok = nextToken(line, c.id) && nextToken(line, c.name) && nextToken(line, c.time) &&
+                 nextToken(line, c.until) && nextInt(line, c.priority) && nextInt(line, c.capacity);
+            break;
+        case COMMAND_SCHEDULE:
+        case COMMAND_ASSIGN:
+        case COMMAND_NEAREST:
+            ok = nextToken(line, c.id) && nextToken(line, c.name) && nextInt(line, c.priority) &&
+                 c.priority >= 0 && nextToken(line, c.target) && nextToken(line, c.time);
+            break;
+        case COMMAND_CANCEL:
+            ok = nextToken(line, c.id) && nextToken(line, c.time) && nextToken(line, c.target);
+            break;
+        case COMMAND_NEXT_FREE:
+            ok = nextToken(line, c.id) && nextToken(line, c.time);
+            break;
+        case COMMAND_CALL:
+        case COMMAND_FIND:
+            ok = nextToken(line, c.id);
+            break;
+        case COMMAND_LIST:
+            ok = true;
+            break;
+        case COMMAND_DAY:
+            ok = nextToken(line, c.time);
+            break;
+    };
+    std::string_view extra;
+    return ok && !nextToken(line, extra) ? COMMAND_OK : COMMAND_MALFORMED;
+}
+
+// Appends a schedule outcome, with the clash details for ALREADY_BOOKED.
+inline void appendScheduleResponse(std::string& out, const ScheduleResult& r){
+    out += scheduleStatusName(r.status);
+    if(r.status == SCHEDULE_ALREADY_BOOKED){
+        out += ' ';
+        out += r.clashDoctorID;
+        out += r.clashWaitlisted ? " WAITING" : " BOOKED";
+    };
+    out += '\n';
+}
+
+#endif
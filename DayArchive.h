@@ -0,0 +1,51 @@
+#ifndef DAYARCHIVE_H
+#define DAYARCHIVE_H
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include "AppointmentJournal.h" // fsync
+
+// appointments.archive: the bookings a day still held when it was closed, in
+// appointments.txt's line format, appended day by day. Archived days are no
+// longer kept in memory, hospital.snapshot or appointments.txt. The archive
+// is opened for one archiving pass and synced on close, before compaction
+// drops those days from the other files, so a crash in between can repeat
+// lines here but never lose them.
+class DayArchive{
+    private:
+        std::string path;
+        FILE* out;
+        size_t lines;
+        size_t slots;
+    public:
+        explicit DayArchive(const std::string& p) : path(p), out(nullptr), lines(0), slots(0) {};
+        DayArchive(const DayArchive&) = delete;
+        DayArchive& operator=(const DayArchive&) = delete;
+        ~DayArchive(){ close(); };
+
+        void append(std::string_view doctorID, std::string_view timeSlot, std::string_view patientID,
+                    std::string_view patientName, int priorityLevel){
+            if(!out) out = std::fopen(path.c_str(), "a");
+            if(!out) return;
+            std::fprintf(out, "%.*s %.*s %.*s %.*s %d\n",
+                         static_cast<int>(doctorID.size()), doctorID.data(),
+                         static_cast<int>(timeSlot.size()), timeSlot.data(),
+                         static_cast<int>(patientID.size()), patientID.data(),
+                         static_cast<int>(patientName.size()), patientName.data(), priorityLevel);
+            lines++;
+        };
+        // A slot was closed, with or without bookings to append.
+        void slotArchived(){ slots++; };
+        void close(){
+            if(!out) return;
+            std::fflush(out);
+            fsync(fileno(out));
+            std::fclose(out);
+            out = nullptr;
+        };
+        size_t size() const { return lines; };
+        size_t slotsArchived() const { return slots; };
+};
+
+#endif
@@ -4,53 +4,49 @@
 #include <string>
 #include <iostream>
 #include "Timeslotinfo.h"
-#include <map>
+#include "Schedule.h"
+#include "Availability.h"
 
 class Doctor{
     private:
         std::string doctorID;
         std::string name;
         std::string specialty;  
-        std::map<std::string, TimeSlotInfo> schedule;
-        
+        Schedule schedule; // keyed by slot key, one partition per day
+        Availability availability; // recurring slots, materialized when first booked
     public:
         
         Doctor(std::string dID, std::string nameDoctor, std::string specialtyDoctor)
         : doctorID(dID), name(nameDoctor), specialty(specialtyDoctor) {
             // Note: uniqueness check (doctorID) is handled in HospitalSystem.
         };
-        void addTimeSlot(const std::string& timeSlot, int capacity){
-            schedule.emplace(timeSlot, TimeSlotInfo(timeSlot, capacity));
+        // Returns the existing slot if the doctor already has one at this time.
+        TimeSlotInfo* addTimeSlot(int key, int capacity){
+            return schedule.insert(key, capacity);
+        };
+        TimeSlotInfo* getTimeSlot(int key){
+            return schedule.find(key);
+        };
+        const TimeSlotInfo* getTimeSlot(int key) const{
+            return schedule.find(key);
         };
-        TimeSlotInfo* getTimeSlot(const std::string& timeSlot){
-            auto it = schedule.find(timeSlot);
-            if(it == schedule.end()){
-                return nullptr;
-            };
-            return &it->second;
+        bool removeTimeSlot(int key){
+            return schedule.erase(key);
         };
-        void printSchedule() const{
-            for(const auto& p : schedule){
-                const TimeSlotInfo& ts = p.second;
-                // Show capacity and current usage for each timeslot
-                std::cout<<"Time Slot Capacity: " << ts.getCapacity() << "\n";
-                std::cout<<"Appointments ( "<<ts.getAppointmentCount()<<" ) at "<<p.first<<"\n";
-                for (const auto& a : ts.getAppointments()) {
-                std::cout << "  " << a.getPatientID()
-                          << " - " << a.getPatientName()
-                          << " (priority " << a.getPriorityLevel() << ")\n";
-                }
-                std::cout << "Waiting List:\n";
-                std::queue<Patient> temp = ts.getWaitingList();
-                while (!temp.empty()) {
-                    Patient p = temp.front();
-                    temp.pop();
-                    std::cout << "  " << p.getpID()
-                              << " - " << p.getnamePat()
-                              << " (priority " << p.getpriLevel() << ")\n";
-                }
-            };
-            
+        void addAvailability(const AvailabilityRule& rule){
+            availability.add(rule);
+        };
+        const Availability& getAvailability() const { return availability; };
+        // Capacity of a slot created at `key`: what the availability rules
+        // give it, or the default of 2 for a doctor without any. 0 means the
+        // doctor does not work then.
+        int capacityFor(int key) const{
+            return availability.empty() ? 2 : availability.capacityAt(key);
+        };
+        // Drops the days before `day`, showing each of their slots to visit first.
+        template <typename Visit>
+        size_t archiveDaysBefore(int day, Visit visit){
+            return schedule.archiveBefore(day, visit);
         };
         const std::string getdName() const{
             return name;
@@ -61,8 +57,7 @@ class Doctor{
         const std::string getdID() const{
             return doctorID;
         };
-         const std::map<std::string, TimeSlotInfo>& getSchedule() const { return schedule; };
+         const Schedule& getSchedule() const { return schedule; };
 };
 
 #endif
-
@@ -0,0 +1,221 @@
+#ifndef DOCTORSHARD_H
+#define DOCTORSHARD_H
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+#include "Doctor.h"
+#include "TriageEntry.h"
+
+// Booked places, total capacity and waiting patients over a whole schedule.
+// Capacity counts slots that exist; places a doctor's availability offers in
+// slots nobody has booked yet are not included.
+struct DoctorLoad{
+    int booked = 0;
+    int capacity = 0;
+    int waitlisted = 0;
+
+    double utilization() const { return capacity ? static_cast<double>(booked) / capacity : 0.0; };
+};
+
+struct DoctorShard;
+struct DoctorView; // ScheduleView.h
+
+// Per-specialty state shared by that specialty's doctors, who update it
+// under their own locks: the load totals summed over them (atomics), and,
+// behind freeLock (taken after a doctor's lock, never before), which doctors
+// have a free place at each slot time and the doctors ordered by bookings.
+struct Specialty{
+    std::atomic<int> doctors{0};
+    std::atomic<int> booked{0};
+    std::atomic<int> capacity{0};
+    std::atomic<int> waitlisted{0};
+
+    std::mutex freeLock;
+    std::map<int, std::set<DoctorShard*>> freeDoctors; // slot key -> doctors with room
+    std::set<std::pair<int, DoctorShard*>> byBooked;   // (booked places, doctor)
+
+    // Doctors with availability rules, whose unbooked slots do not exist
+    // and so are in no index; each caches its next one (DoctorShard::offered).
+    // Shape guarded like HospitalSystem::doctors.
+    std::vector<DoctorShard*> withAvailability;
+};
+
+// Everything HospitalSystem keeps per doctor, behind that doctor's own lock.
+// Operations on different doctors never wait for each other.
+struct DoctorShard{
+    Doctor doctor;
+    NameId doctorKey;         // interned doctor ID, for triage and index records
+    TriageQueue triage;
+    DoctorLoad load;          // kept up to date on every change, never recounted
+    std::atomic<int> booked{0}; // load.booked, readable without the lock
+    std::set<int> freeSlots;  // keys of slots with a free appointment place
+    Specialty* specialty;     // owned by HospitalSystem, stable for its lifetime
+    mutable std::mutex lock;
+
+    // nextUnbooked(from, -1) as last worked out, packed as from << 32 | key
+    // (NO_KEY for none), so scheduleBySpecialty reads it without the lock:
+    // it answers any query from a time between the two. Cleared under the
+    // lock when a slot in that range comes or goes or the rules change.
+    static const uint64_t NO_OFFER = ~0ull;
+    static const uint32_t NO_KEY = 0x7FFFFFFFu;
+    std::atomic<uint64_t> offered{NO_OFFER};
+
+    // Read-only copy for reports (ScheduleView.h), republished by the writer
+    // after each change; read and replaced only with std::atomic_load /
+    // std::atomic_store. The rest is guarded by lock.
+    mutable std::shared_ptr<const DoctorView> view;
+    mutable std::vector<int> changedSlots; // keys of slots changed since view was published
+    mutable bool viewStale = true;        // anything changed since then
+
+    explicit DoctorShard(const Doctor& d)
+    : doctor(d), doctorKey(names().intern(d.getdID())), specialty(nullptr) {};
+
+    void joinSpecialty(Specialty* sp){
+        specialty = sp;
+        specialty->doctors++;
+        std::lock_guard<std::mutex> guard(specialty->freeLock);
+        specialty->byBooked.insert({load.booked, this});
+    };
+
+    // Whether a triage entry still stands for a booked appointment: the
+    // patient holds this slot under the same order stamp. A cancel and
+    // rebook leaves the old entry behind with an older stamp.
+    bool isCurrent(const TriageEntry& e) const{
+        const TimeSlotInfo* slot = doctor.getTimeSlot(e.slotMinute);
+        const Appointment* a = slot ? slot->getAppointments().find(e.patientID) : nullptr;
+        return a && a->getTriageOrder() == e.order;
+    };
+    // Call with the lock held when a booked appointment goes away other than
+    // by being called. Returns the tombstones dropped if that triggered a
+    // compaction of the heap, else 0.
+    size_t appointmentDropped(){
+        if(!triage.addStale()) return 0;
+        return triage.compact([this](const TriageEntry& e){ return isCurrent(e); });
+    };
+
+    // First key at or after `from`, and not after `limit` if that is >= 0,
+    // where the availability offers a slot that does not exist yet; -1 if
+    // none. Existing slots with room are in the specialty index already.
+    int nextUnbooked(int from, int limit) const{
+        const Availability& a = doctor.getAvailability();
+        for(int key = a.nextOffered(from); key >= 0 && (limit < 0 || key <= limit);
+            key = a.nextOffered(key + 1)){
+            if(!doctor.getTimeSlot(key)) return key;
+        };
+        return -1;
+    };
+    // Earliest key at or after `from` where a booking gets a place rather
+    // than a waiting-list spot, or -1: the first existing slot with room
+    // (freeSlots, O(log n)), unless a time the availability offers has no
+    // slot yet before it (a walk over the full slots in between). A doctor
+    // without availability can always open a slot at `from` itself if
+    // there is none, but no new times are invented after a full one.
+    int nextFree(int from) const{
+        auto it = freeSlots.lower_bound(from);
+        int existing = it == freeSlots.end() ? -1 : *it;
+        if(doctor.getAvailability().empty())
+            return doctor.getTimeSlot(from) ? existing : from;
+        int unbooked = nextUnbooked(from, existing);
+        return unbooked >= 0 && (existing < 0 || unbooked < existing) ? unbooked : existing;
+    };
+    // nextUnbooked(from, -1) from the offered cache when it covers `from`,
+    // else worked out under the lock (which must not be held) and cached.
+    int cachedNextUnbooked(int from){
+        uint64_t c = offered.load(std::memory_order_acquire);
+        if(c != NO_OFFER && static_cast<int>(c >> 32) <= from && from <= static_cast<int>(c & NO_KEY))
+            return (c & NO_KEY) == NO_KEY ? -1 : static_cast<int>(c & NO_KEY);
+        std::lock_guard<std::mutex> guard(lock);
+        int key = nextUnbooked(from, -1);
+        offered.store(static_cast<uint64_t>(from) << 32 | (key < 0 ? NO_KEY : static_cast<uint32_t>(key)),
+                      std::memory_order_release);
+        return key;
+    };
+    // Call with the lock held after a slot lost a booking or waiting patient.
+    // An empty slot the availability would recreate exactly as it is goes
+    // back to being implicit, so memory follows bookings, not the calendar.
+    void releaseIfIdle(const TimeSlotInfo& slot){
+        const Availability& a = doctor.getAvailability();
+        if(a.empty() || slot.getAppointmentCount() > 0 || !slot.getWaitingList().empty() ||
+           slot.getCapacity() != a.capacityAt(slot.getMinute())) return;
+        int key = slot.getMinute();
+        slotDropped(slot);
+        doctor.removeTimeSlot(key);
+    };
+
+    // Call with the lock held whenever a place is booked, freed or added.
+    void adjust(int booked, int capacity, int waitlisted){
+        if(booked != 0){
+            std::lock_guard<std::mutex> guard(specialty->freeLock);
+            specialty->byBooked.erase({load.booked, this});
+            specialty->byBooked.insert({load.booked + booked, this});
+        };
+        load.booked += booked;
+        this->booked.store(load.booked, std::memory_order_relaxed);
+        load.capacity += capacity;
+        load.waitlisted += waitlisted;
+        specialty->booked.fetch_add(booked, std::memory_order_relaxed);
+        specialty->capacity.fetch_add(capacity, std::memory_order_relaxed);
+        specialty->waitlisted.fetch_add(waitlisted, std::memory_order_relaxed);
+    };
+    // Call with the lock held after a slot is created or its bookings or
+    // waiting list change; it is copied into the next view. The
+    // specialty index is only touched when the slot fills up or frees up.
+    void slotChanged(const TimeSlotInfo& slot){
+        int minute = slot.getMinute();
+        keyChanged(minute);
+        if(slot.isFullAppointments()){
+            if(freeSlots.erase(minute)) unindexFree(minute);
+        }else{
+            if(!freeSlots.insert(minute).second) return;
+            std::lock_guard<std::mutex> guard(specialty->freeLock);
+            specialty->freeDoctors[minute].insert(this);
+        };
+    };
+    // A slot left the schedule (its day was archived): take it out of the
+    // totals and indexes.
+    void slotDropped(const TimeSlotInfo& slot){
+        keyChanged(slot.getMinute());
+        adjust(-static_cast<int>(slot.getAppointmentCount()), -slot.getCapacity(),
+               -static_cast<int>(slot.getWaitingList().size()));
+        if(freeSlots.erase(slot.getMinute())) unindexFree(slot.getMinute());
+    };
+    // The published view no longer shows this slot as it is. Until the
+    // first view is built (at load) nothing needs recording.
+    void keyChanged(int key){
+        viewStale = true;
+        uint64_t c = offered.load(std::memory_order_relaxed);
+        if(c != NO_OFFER && static_cast<int>(c >> 32) <= key && key <= static_cast<int>(c & NO_KEY))
+            offered.store(NO_OFFER, std::memory_order_relaxed);
+        if(!view) return;
+        if(changedSlots.empty() || changedSlots.back() != key) changedSlots.push_back(key);
+    };
+    // Call with the lock held after the availability rules change.
+    void rulesChanged(){
+        viewStale = true;
+        offered.store(NO_OFFER, std::memory_order_relaxed);
+    };
+    // Back to an empty schedule, as far as the totals and indexes know.
+    void resetLoad(){
+        clearFreeSlots();
+        adjust(-load.booked, -load.capacity, -load.waitlisted);
+    };
+    void clearFreeSlots(){
+        for(int minute : freeSlots) unindexFree(minute);
+        freeSlots.clear();
+    };
+    void unindexFree(int minute){
+        std::lock_guard<std::mutex> guard(specialty->freeLock);
+        auto it = specialty->freeDoctors.find(minute);
+        it->second.erase(this);
+        if(it->second.empty()){
+            specialty->freeDoctors.erase(it);
+        };
+    };
+};
+
+#endif
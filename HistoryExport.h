@@ -0,0 +1,422 @@
+#ifndef HISTORYEXPORT_H
+#define HISTORYEXPORT_H
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "HospitalEvents.h"
+#include "MappedFile.h"
+#include "SlotTime.h"
+
+// history-NNNNN.csv: every event the system emits, as CSV chunks of at most
+// rowsPerChunk rows, each with its own header line:
+//
+//   time_ms,event,status,doctor,slot,patient,name,priority,wait_ms
+//
+// time_ms is wall-clock milliseconds since 1970; event is doctor_added,
+// scheduled, cancelled, promoted or called; status is the upper-case name
+// from HospitalStatus.h. wait_ms, on promoted, cancelled and called rows, is
+// how long after the slot's time the event happened, on the local clock slot
+// keys count in, and 0 if the slot had not started yet: the wait triage aging
+// uses (TriageEntry.h). It needs no earlier event, so bookings made before a
+// restart get it too.
+//
+// onEvent only copies the event into a queue; a writer thread formats the
+// rows and writes them, so threads booking for different doctors never wait
+// on each other's rows. The writer takes the queue every WAKE_MS, or once it
+// holds WAKE_BYTES, so it is not woken per event; when it falls behind by
+// QUEUE_BYTES, onEvent waits for it.
+//
+// A chunk is written as history-NNNNN.csv.part and renamed once it is full or
+// the exporter closes, so a reader only ever sees complete chunks. Memory is
+// bounded by the queue and the write buffer.
+// A chunk that cannot be created is reported on std::cerr and its rows are
+// dropped (see droppedCount). The files are analytics, not a journal: they
+// are flushed, not fsync'ed.
+class HistoryExporter : public HospitalEventSink{
+    private:
+        typedef std::chrono::steady_clock Clock;
+        // Fixed part of a queued event; doctor, slot, patient and name
+        // follow it in the queue, sizes[i] bytes each.
+        struct Queued{
+            Clock::rep at;
+            int type;
+            int status;
+            int priorityLevel;
+            int day;
+            uint32_t sizes[4];
+        };
+
+        std::string prefix;
+        size_t rowsPerChunk;
+
+        // Queue, filled by onEvent and emptied by the writer.
+        std::mutex queueLock;
+        std::condition_variable ready;   // WAKE_BYTES pending, a drain, or stopping
+        std::condition_variable drained; // written or pending.size() moved
+        std::string pending;
+        size_t queued;    // events queued so far
+        size_t written;   // of them, the ones the writer has finished
+        size_t drainTo;   // events a drain waits for; taken without waiting for WAKE_BYTES
+        bool stopping;
+
+        // Writer state; writeLock is held by the writer while it formats a
+        // batch, and by flush/close and the counters.
+        mutable std::mutex writeLock;
+        FILE* out;
+        int chunk;        // index of the chunk being written
+        size_t rows;      // rows in it
+        size_t rowsTotal;
+        size_t bytesTotal;
+        size_t droppedTotal;
+        bool reported;    // the current chunk's failure is already on std::cerr
+        Clock::time_point steadyStart;
+        long long wallStartMs;
+        long long wallSecond;  // last second localMs converted, and that second
+        long long localSecond; // on the local clock
+        std::string buffer;
+        std::thread writer;
+
+        static const size_t BUFFER_BYTES = 64 * 1024;
+        static const size_t WAKE_BYTES = 256 * 1024;
+        static const size_t QUEUE_BYTES = 4 * 1024 * 1024;
+        static constexpr int WAKE_MS = 50;
+
+        std::string chunkPath(int index) const{
+            char digits[16];
+            std::snprintf(digits, sizeof digits, "-%05d.csv", index);
+            return prefix + digits;
+        };
+        void report(const std::string& path){
+            if(reported) return;
+            std::cerr << "Cannot write " << path << ": " << std::strerror(errno) << "\n";
+            reported = true;
+        };
+        void flushBuffer(){
+            if(out && !buffer.empty()){
+                size_t n = std::fwrite(buffer.data(), 1, buffer.size(), out);
+                bytesTotal += n;
+                if(n < buffer.size()) report(chunkPath(chunk) + ".part");
+            };
+            buffer.clear();
+        };
+        void closeChunk(){
+            if(out){
+                flushBuffer();
+                std::fclose(out);
+                out = nullptr;
+                std::rename((chunkPath(chunk) + ".part").c_str(), chunkPath(chunk).c_str());
+                chunk++;
+            };
+            rows = 0;
+        };
+        void openChunk(){
+            std::string path = chunkPath(chunk) + ".part";
+            reported = false;
+            out = std::fopen(path.c_str(), "w");
+            if(out) buffer += "time_ms,event,status,doctor,slot,patient,name,priority,wait_ms\n";
+            else report(path);
+        };
+        void field(std::string_view s){
+            if(s.find_first_of(",\"\n") == std::string_view::npos){
+                buffer += s;
+                return;
+            };
+            buffer += '"';
+            for(char c : s){
+                if(c == '"') buffer += '"';
+                buffer += c;
+            };
+            buffer += '"';
+        };
+        // Wall-clock milliseconds as the local clock reads them; one
+        // conversion per second of events.
+        long long localMs(long long wallMs){
+            long long second = wallMs / 1000;
+            if(second != wallSecond){
+                std::tm t = localTime(static_cast<std::time_t>(second));
+                localSecond = (static_cast<long long>(daysFromCivil(t.tm_year + 1900, t.tm_mon + 1, t.tm_mday)) *
+                               MINUTES_PER_DAY + t.tm_hour * 60 + t.tm_min) * 60 + t.tm_sec;
+                wallSecond = second;
+            };
+            return localSecond * 1000 + wallMs % 1000;
+        };
+        // How long after e's slot time wallMs is, 0 before it; -1 if the
+        // slot cannot be read.
+        long long waited(const HospitalEvent& e, long long wallMs){
+            int key = parseSlotTime(e.timeSlot, e.day < 0 ? currentDay() : e.day);
+            if(key < 0) return -1;
+            return std::max(0LL, localMs(wallMs) - static_cast<long long>(key) * 60000);
+        };
+        void row(const HospitalEvent& e, long long wallMs, const char* event, const char* status,
+                 long long waitMs){
+            if(rows == rowsPerChunk) closeChunk();
+            if(rows == 0) openChunk();
+            rows++;
+            if(!out){
+                droppedTotal++;
+                return;
+            };
+            buffer += std::to_string(wallMs);
+            buffer += ',';
+            buffer += event;
+            buffer += ',';
+            buffer += status;
+            buffer += ',';
+            field(e.doctorID);
+            buffer += ',';
+            field(e.timeSlot);
+            buffer += ',';
+            field(e.patientID);
+            buffer += ',';
+            field(e.patientName);
+            buffer += ',';
+            if(e.type == EVENT_SCHEDULED || e.type == EVENT_PROMOTED || e.type == EVENT_CALLED)
+                buffer += std::to_string(e.priorityLevel);
+            buffer += ',';
+            if(waitMs >= 0) buffer += std::to_string(waitMs);
+            buffer += '\n';
+            rowsTotal++;
+            if(buffer.size() >= BUFFER_BYTES) flushBuffer();
+        };
+        void write(const HospitalEvent& e, Clock::time_point at){
+            long long ms = wallStartMs + std::chrono::duration_cast<std::chrono::milliseconds>(at - steadyStart).count();
+            switch(e.type){
+                case EVENT_DOCTOR_ADDED:
+                    row(e, ms, "doctor_added", doctorStatusName(static_cast<DoctorStatus>(e.status)), -1);
+                    break;
+                case EVENT_SCHEDULED:
+                    row(e, ms, "scheduled", scheduleStatusName(static_cast<ScheduleStatus>(e.status)), -1);
+                    break;
+                case EVENT_CANCELLED:
+                    row(e, ms, "cancelled", cancelStatusName(static_cast<CancelStatus>(e.status)),
+                        e.status == CANCEL_DONE ? waited(e, ms) : -1);
+                    break;
+                case EVENT_PROMOTED:
+                    row(e, ms, "promoted", "PROMOTED", waited(e, ms));
+                    break;
+                case EVENT_CALLED:
+                    row(e, ms, "called", callStatusName(static_cast<CallStatus>(e.status)),
+                        e.status == CALL_DONE ? waited(e, ms) : -1);
+                    break;
+            };
+        };
+        // Formats the queued events of batch, in queue order.
+        void writeBatch(std::string_view batch){
+            std::lock_guard<std::mutex> guard(writeLock);
+            while(!batch.empty()){
+                Queued q;
+                std::memcpy(&q, batch.data(), sizeof q);
+                batch.remove_prefix(sizeof q);
+                std::string_view text[4];
+                for(int i = 0; i < 4; i++){
+                    text[i] = batch.substr(0, q.sizes[i]);
+                    batch.remove_prefix(q.sizes[i]);
+                };
+                HospitalEvent e{static_cast<HospitalEventType>(q.type), q.status, text[0], text[1],
+                                text[2], text[3], q.priorityLevel, {}, false, q.day};
+                write(e, Clock::time_point(Clock::duration(q.at)));
+            };
+        };
+        void writeLoop(){
+            std::string batch;
+            std::unique_lock<std::mutex> queue(queueLock);
+            while(true){
+                ready.wait_for(queue, std::chrono::milliseconds(WAKE_MS), [this]{
+                    return pending.size() >= WAKE_BYTES || written < drainTo || stopping;
+                });
+                if(pending.empty()){
+                    if(stopping) return;
+                    continue;
+                };
+                batch.swap(pending);
+                size_t upTo = queued;
+                drained.notify_all();
+                queue.unlock();
+                writeBatch(batch);
+                batch.clear();
+                queue.lock();
+                written = upTo;
+                drained.notify_all();
+            };
+        };
+        // Waits until every event queued before the call is written.
+        void drain(){
+            std::unique_lock<std::mutex> queue(queueLock);
+            size_t target = queued;
+            drainTo = target;
+            ready.notify_one();
+            drained.wait(queue, [&]{ return written >= target; });
+        };
+    public:
+        // Chunks are numbered on from any already in place; a .part chunk
+        // left by a crash is completed as it is.
+        explicit HistoryExporter(const std::string& filePrefix = "history", size_t chunkRows = 100000)
+        : prefix(filePrefix), rowsPerChunk(chunkRows ? chunkRows : 1), queued(0), written(0),
+          drainTo(0), stopping(false), out(nullptr), chunk(0), rows(0), rowsTotal(0), bytesTotal(0),
+          droppedTotal(0), reported(false), steadyStart(Clock::now()),
+          wallStartMs(std::chrono::duration_cast<std::chrono::milliseconds>(
+              std::chrono::system_clock::now().time_since_epoch()).count()),
+          wallSecond(-1), localSecond(0) {
+            while(true){
+                std::string path = chunkPath(chunk);
+                if(FILE* f = std::fopen(path.c_str(), "r")){
+                    std::fclose(f);
+                }else if(std::rename((path + ".part").c_str(), path.c_str()) != 0){
+                    break;
+                };
+                chunk++;
+            };
+            buffer.reserve(BUFFER_BYTES + 1024);
+            writer = std::thread(&HistoryExporter::writeLoop, this);
+        };
+        HistoryExporter(const HistoryExporter&) = delete;
+        HistoryExporter& operator=(const HistoryExporter&) = delete;
+        // Writes out what is queued and completes the current chunk.
+        ~HistoryExporter(){
+            {
+                std::lock_guard<std::mutex> queue(queueLock);
+                stopping = true;
+            };
+            ready.notify_one();
+            writer.join();
+            std::lock_guard<std::mutex> guard(writeLock);
+            closeChunk();
+        };
+
+        void onEvent(const HospitalEvent& e) override{
+            Queued q{Clock::now().time_since_epoch().count(), e.type, e.status, e.priorityLevel, e.day,
+                     {static_cast<uint32_t>(e.doctorID.size()), static_cast<uint32_t>(e.timeSlot.size()),
+                      static_cast<uint32_t>(e.patientID.size()), static_cast<uint32_t>(e.patientName.size())}};
+            std::unique_lock<std::mutex> queue(queueLock);
+            if(pending.size() >= QUEUE_BYTES)
+                drained.wait(queue, [this]{ return pending.size() < QUEUE_BYTES; });
+            bool wake = pending.size() < WAKE_BYTES;
+            pending.append(reinterpret_cast<const char*>(&q), sizeof q);
+            pending += e.doctorID;
+            pending += e.timeSlot;
+            pending += e.patientID;
+            pending += e.patientName;
+            queued++;
+            wake = wake && pending.size() >= WAKE_BYTES;
+            queue.unlock();
+            if(wake) ready.notify_one();
+        };
+        // Writes every event sent so far out to the current chunk.
+        void flush(){
+            drain();
+            std::lock_guard<std::mutex> guard(writeLock);
+            flushBuffer();
+            if(out) std::fflush(out);
+        };
+        // Writes every event sent so far and completes the current chunk; a
+        // later event starts a new one.
+        void close(){
+            drain();
+            std::lock_guard<std::mutex> guard(writeLock);
+            closeChunk();
+        };
+        // Rows written so far (queued events not included).
+        size_t rowCount() const{
+            std::lock_guard<std::mutex> guard(writeLock);
+            return rowsTotal;
+        };
+        // Bytes the files took so far (buffered rows not included).
+        size_t byteCount() const{
+            std::lock_guard<std::mutex> guard(writeLock);
+            return bytesTotal;
+        };
+        // Rows lost to chunks that could not be created.
+        size_t droppedCount() const{
+            std::lock_guard<std::mutex> guard(writeLock);
+            return droppedTotal;
+        };
+};
+
+const int HISTORY_FIELDS = 9;
+
+// One row of a history chunk; the views are valid during the visit only.
+struct HistoryRow{
+    long long timeMs;
+    std::string_view event;
+    std::string_view status;
+    std::string_view doctorID;
+    std::string_view timeSlot;
+    std::string_view patientID;
+    std::string_view patientName;
+    int priorityLevel; // -1 if empty
+    long long waitMs;  // -1 if empty
+};
+
+// Next CSV field of a line, unquoted into `scratch` when it was quoted.
+inline std::string_view nextHistoryField(std::string_view& line, std::string& scratch){
+    if(line.empty() || line[0] != '"'){
+        size_t comma = line.find(',');
+        std::string_view f = line.substr(0, comma);
+        line = comma == std::string_view::npos ? std::string_view() : line.substr(comma + 1);
+        return f;
+    };
+    scratch.clear();
+    size_t i = 1;
+    for(; i < line.size(); i++){
+        if(line[i] == '"'){
+            if(i + 1 < line.size() && line[i + 1] == '"'){
+                scratch += '"';
+                i++;
+                continue;
+            };
+            break;
+        };
+        scratch += line[i];
+    };
+    line = i + 2 <= line.size() ? line.substr(i + 2) : std::string_view();
+    return scratch;
+}
+
+// Streams every row of the complete chunks prefix-00000.csv,
+// prefix-00001.csv, ... to visit, one mapped chunk at a time, so a history
+// of any length is read in the memory of one chunk. Returns the row count.
+template <typename Visit>
+size_t forEachHistoryRow(const std::string& prefix, Visit visit){
+    size_t count = 0;
+    std::string quoted[HISTORY_FIELDS];
+    for(int index = 0; ; index++){
+        char digits[16];
+        std::snprintf(digits, sizeof digits, "-%05d.csv", index);
+        MappedFile file(prefix + digits);
+        if(!file.isOpen()) break;
+        std::string_view rest = file.view();
+        bool header = true;
+        while(!rest.empty()){
+            // A quoted name never holds a newline (names are single tokens).
+            size_t end = rest.find('\n');
+            std::string_view line = rest.substr(0, end);
+            rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+            if(header || line.empty()){
+                header = false;
+                continue;
+            };
+            std::string_view f[HISTORY_FIELDS];
+            for(int i = 0; i < HISTORY_FIELDS; i++) f[i] = nextHistoryField(line, quoted[i]);
+            HistoryRow r{0, f[1], f[2], f[3], f[4], f[5], f[6], -1, -1};
+            std::from_chars(f[0].data(), f[0].data() + f[0].size(), r.timeMs);
+            std::from_chars(f[7].data(), f[7].data() + f[7].size(), r.priorityLevel);
+            std::from_chars(f[8].data(), f[8].data() + f[8].size(), r.waitMs);
+            visit(r);
+            count++;
+        };
+    };
+    return count;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef HOSPITALEVENTS_H
+#define HOSPITALEVENTS_H
+
+#include <iostream>
+#include <mutex>
+#include <string_view>
+#include "HospitalStatus.h"
+
+enum HospitalEventType {
+    EVENT_DOCTOR_ADDED, // status: DoctorStatus
+    EVENT_SCHEDULED,    // status: ScheduleStatus
+    EVENT_CANCELLED,    // status: CancelStatus
+    EVENT_PROMOTED,     // waiting patient moved into the slot; always succeeds
+    EVENT_CALLED        // status: CallStatus
+};
+
+// One operation outcome. The views point into HospitalSystem's own strings
+// and are only valid during onEvent; copy what you keep.
+struct HospitalEvent{
+    HospitalEventType type;
+    int status;
+    std::string_view doctorID;
+    std::string_view timeSlot;
+    std::string_view patientID;
+    std::string_view patientName;
+    int priorityLevel;
+    std::string_view clashDoctorID; // SCHEDULE_ALREADY_BOOKED only
+    bool clashWaitlisted;
+    int day = -1;                   // HospitalSystem's today when sent
+};
+
+// Receives every outcome of addDoctor, scheduling, cancellation, promotion
+// and calls. onEvent runs on the calling thread and must not call back into
+// HospitalSystem. Outcomes that changed a doctor's bookings (booked,
+// waitlisted, cancelled, promoted, called) are sent with that doctor's lock
+// held, so they arrive in the order they happened. Rejections (unknown
+// doctor, invalid time, appointment not found, ...) may be sent with no lock
+// held and can arrive out of order with other threads' events; the sink must
+// be thread-safe.
+class HospitalEventSink{
+    public:
+        virtual ~HospitalEventSink() {};
+        virtual void onEvent(const HospitalEvent& e) = 0;
+};
+
+// Default sink: for headless use (benchmarks, imports, servers).
+class NullEventSink : public HospitalEventSink{
+    public:
+        void onEvent(const HospitalEvent&) override {};
+};
+
+// Hands every event to two sinks, first then second; e.g. the menu's console
+// and an exporter installed before it.
+class TeeEventSink : public HospitalEventSink{
+    private:
+        HospitalEventSink& first;
+        HospitalEventSink& second;
+    public:
+        TeeEventSink(HospitalEventSink& a, HospitalEventSink& b) : first(a), second(b) {};
+        void onEvent(const HospitalEvent& e) override{
+            first.onEvent(e);
+            second.onEvent(e);
+        };
+};
+
+// Renders events as the interactive menu's messages.
+class ConsoleEventSink : public HospitalEventSink{
+    private:
+        std::ostream& out;
+        std::mutex lock;
+
+        void scheduled(const HospitalEvent& e){
+            if(e.status == SCHEDULE_ALREADY_BOOKED){
+                out << "Patient is already " << (e.clashWaitlisted ? "waiting" : "booked")
+                    << " at " << e.timeSlot << " with doctor " << e.clashDoctorID << ".\n";
+                return;
+            };
+            out << scheduleStatusText(static_cast<ScheduleStatus>(e.status)) << "\n";
+        };
+        void cancelled(const HospitalEvent& e){
+            switch(e.status){
+                case CANCEL_DONE:             out << "Appointment cancelled.\n"; break;
+                case CANCEL_DOCTOR_NOT_FOUND: out << "Doctor not found.\n"; break;
+                case CANCEL_SLOT_NOT_FOUND:   out << "Time slot not found.\n"; break;
+                case CANCEL_NOT_FOUND:        out << "Appointment not found.\n"; break;
+            };
+        };
+        void called(const HospitalEvent& e){
+            switch(e.status){
+                case CALL_DONE:
+                    out << "\n=== NEXT PATIENT ===\n";
+                    out << "Patient ID : " << e.patientID << "\n";
+                    out << "Name       : " << e.patientName << "\n";
+                    out << "Priority   : " << e.priorityLevel << "\n";
+                    out << "Doctor     : " << e.doctorID << "\n";
+                    out << "Time Slot  : " << e.timeSlot << "\n";
+                    out << "\nPatient has been called.\n";
+                    break;
+                case CALL_DOCTOR_NOT_FOUND: out << "Doctor not found.\n"; break;
+                case CALL_QUEUE_EMPTY:      out << "No patients waiting.\n"; break;
+                case CALL_NO_VALID_PATIENT: out << "No valid patients for this doctor.\n"; break;
+            };
+        };
+    public:
+        explicit ConsoleEventSink(std::ostream& o = std::cout) : out(o) {};
+        void onEvent(const HospitalEvent& e) override{
+            std::lock_guard<std::mutex> guard(lock);
+            switch(e.type){
+                case EVENT_DOCTOR_ADDED:
+                    out << (e.status == DOCTOR_ADDED ? "Doctor added successfully." : "Doctor ID is exists")
+                        << std::endl;
+                    break;
+                case EVENT_SCHEDULED: scheduled(e); break;
+                case EVENT_CANCELLED: cancelled(e); break;
+                case EVENT_PROMOTED:  out << e.patientName << " moved from waiting list.\n"; break;
+                case EVENT_CALLED:    called(e); break;
+            };
+        };
+};
+
+#endif
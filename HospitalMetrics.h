@@ -0,0 +1,159 @@
+#ifndef HOSPITALMETRICS_H
+#define HOSPITALMETRICS_H
+
+// Operation counters and latency histograms for HospitalSystem. Build with
+// -DHOSPITAL_METRICS=0 to compile every probe out; the per-doctor and
+// per-slot gauges are computed only when metrics are exported, so they cost
+// nothing on the hot path either way.
+#ifndef HOSPITAL_METRICS
+#define HOSPITAL_METRICS 1
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+enum MetricOp {
+    METRIC_SCHEDULE,
+    METRIC_SCHEDULE_BATCH,
+    METRIC_ASSIGN,
+    METRIC_NEAREST,
+    METRIC_CANCEL,
+    METRIC_CALL,
+    METRIC_LIST_DOCTORS,
+    METRIC_COMPACTION,
+    METRIC_LOAD,
+    METRIC_OP_COUNT
+};
+
+inline const char* metricOpName(MetricOp op){
+    switch(op){
+        case METRIC_SCHEDULE:       return "schedule";
+        case METRIC_SCHEDULE_BATCH: return "schedule_batch";
+        case METRIC_ASSIGN:         return "assign";
+        case METRIC_NEAREST:        return "nearest";
+        case METRIC_CANCEL:         return "cancel";
+        case METRIC_CALL:           return "call";
+        case METRIC_LIST_DOCTORS:   return "list_doctors";
+        case METRIC_COMPACTION:     return "compaction";
+        case METRIC_LOAD:           return "load";
+        case METRIC_OP_COUNT:       break;
+    };
+    return "";
+}
+
+#if HOSPITAL_METRICS
+
+// Lock-free: every probe is a few relaxed atomic adds. Latency buckets are
+// powers of two from 256 ns up to ~1 s, plus an overflow bucket.
+class HospitalMetrics{
+    public:
+        static const int BUCKETS = 24;
+        static const int FIRST_BUCKET_SHIFT = 8; // bucket 0: <= 2^8 ns
+
+    private:
+        struct OpStats{
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> totalNs{0};
+            std::atomic<uint64_t> buckets[BUCKETS + 1] = {};
+        };
+        OpStats ops[METRIC_OP_COUNT];
+        std::atomic<uint64_t> staleTriagePops{0};
+        std::atomic<uint64_t> triageCompacted{0};
+
+        static int bucketFor(uint64_t ns){
+            int b = 0;
+            ns >>= FIRST_BUCKET_SHIFT;
+            while(ns > 0 && b < BUCKETS){
+                ns >>= 1;
+                b++;
+            };
+            return b;
+        };
+    public:
+        void record(MetricOp op, uint64_t ns){
+            OpStats& s = ops[op];
+            s.count.fetch_add(1, std::memory_order_relaxed);
+            s.totalNs.fetch_add(ns, std::memory_order_relaxed);
+            s.buckets[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+        };
+        // Heap entries callNextPatient threw away because the patient had
+        // already been cancelled or called.
+        void addStaleTriagePops(uint64_t n){
+            staleTriagePops.fetch_add(n, std::memory_order_relaxed);
+        };
+        // Tombstones dropped by compacting a doctor's triage heap.
+        void addTriageCompacted(uint64_t n){
+            triageCompacted.fetch_add(n, std::memory_order_relaxed);
+        };
+
+        // Prometheus text exposition format.
+        void write(std::ostream& out) const{
+            out << "# HELP hms_operations_total Completed HospitalSystem operations.\n";
+            out << "# TYPE hms_operations_total counter\n";
+            for(int op = 0; op < METRIC_OP_COUNT; op++){
+                out << "hms_operations_total{op=\"" << metricOpName(static_cast<MetricOp>(op)) << "\"} "
+                    << ops[op].count.load(std::memory_order_relaxed) << "\n";
+            };
+            out << "# HELP hms_operation_latency_seconds Wall time per operation.\n";
+            out << "# TYPE hms_operation_latency_seconds histogram\n";
+            for(int op = 0; op < METRIC_OP_COUNT; op++){
+                const char* name = metricOpName(static_cast<MetricOp>(op));
+                uint64_t cumulative = 0;
+                for(int b = 0; b < BUCKETS; b++){
+                    cumulative += ops[op].buckets[b].load(std::memory_order_relaxed);
+                    out << "hms_operation_latency_seconds_bucket{op=\"" << name << "\",le=\""
+                        << static_cast<double>(uint64_t(1) << (FIRST_BUCKET_SHIFT + b)) / 1e9 << "\"} "
+                        << cumulative << "\n";
+                };
+                cumulative += ops[op].buckets[BUCKETS].load(std::memory_order_relaxed);
+                out << "hms_operation_latency_seconds_bucket{op=\"" << name << "\",le=\"+Inf\"} "
+                    << cumulative << "\n";
+                out << "hms_operation_latency_seconds_sum{op=\"" << name << "\"} "
+                    << ops[op].totalNs.load(std::memory_order_relaxed) / 1e9 << "\n";
+                out << "hms_operation_latency_seconds_count{op=\"" << name << "\"} " << cumulative << "\n";
+            };
+            out << "# HELP hms_triage_stale_pops_total Cancelled or called entries skipped by callNextPatient.\n";
+            out << "# TYPE hms_triage_stale_pops_total counter\n";
+            out << "hms_triage_stale_pops_total " << staleTriagePops.load(std::memory_order_relaxed) << "\n";
+            out << "# HELP hms_triage_compacted_total Cancelled entries dropped by triage heap compaction.\n";
+            out << "# TYPE hms_triage_compacted_total counter\n";
+            out << "hms_triage_compacted_total " << triageCompacted.load(std::memory_order_relaxed) << "\n";
+        };
+};
+
+// Times the enclosing scope.
+class MetricTimer{
+    private:
+        HospitalMetrics& metrics;
+        MetricOp op;
+        std::chrono::steady_clock::time_point start;
+    public:
+        MetricTimer(HospitalMetrics& m, MetricOp o)
+        : metrics(m), op(o), start(std::chrono::steady_clock::now()) {};
+        ~MetricTimer(){
+            metrics.record(op, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                   std::chrono::steady_clock::now() - start).count());
+        };
+};
+
+#define HOSPITAL_METRIC_TIMER(metrics, op) MetricTimer metricTimer_(metrics, op)
+#define HOSPITAL_METRIC_STALE_POPS(metrics, n) (metrics).addStaleTriagePops(n)
+#define HOSPITAL_METRIC_TRIAGE_COMPACTED(metrics, n) (metrics).addTriageCompacted(n)
+
+#else
+
+// Compiled out: same interface, nothing recorded.
+class HospitalMetrics{
+    public:
+        void write(std::ostream&) const {};
+};
+
+#define HOSPITAL_METRIC_TIMER(metrics, op) ((void)0)
+#define HOSPITAL_METRIC_STALE_POPS(metrics, n) ((void)(n))
+#define HOSPITAL_METRIC_TRIAGE_COMPACTED(metrics, n) ((void)(n))
+
+#endif
+
+#endif
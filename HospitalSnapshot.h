@@ -0,0 +1,139 @@
+#ifndef HOSPITALSNAPSHOT_H
+#define HOSPITALSNAPSHOT_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// On-disk layout of hospital.snapshot (native byte order, checked by magic):
+//
+//   SnapshotHeader
+//   payload: SnapshotCounts, then the sections below, each a packed array
+//     uint32_t stringOffsets[strings + 1]; char stringBytes[...]
+//     SnapshotDoctor[doctors]      (id/name/specialty are string indices)
+//     SnapshotSlot[slots]          (doctors' slots, back to back)
+//     SnapshotAppointment[appointments]
+//     SnapshotWaiting[waiting]
+//
+// Every record is fixed-size POD, so loading is a checksum pass plus one
+// memcpy per section before the objects are rebuilt.
+
+const char SNAPSHOT_MAGIC[8] = {'H', 'M', 'S', 'S', 'N', 'A', 'P', '\0'};
+const uint32_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+
+struct SnapshotCounts{
+    int32_t journalEpoch;       // journal epochs up to this one are included
+    int32_t triageOrderCounter;
+    uint32_t strings;
+    uint32_t stringBytes;
+    uint32_t doctors;
+    uint32_t slots;
+    uint32_t appointments;
+    uint32_t waiting;
+};
+
+struct SnapshotDoctor{
+    uint32_t id, name, specialty;
+    uint32_t slotCount;
+};
+
+struct SnapshotSlot{
+    uint32_t timeSlot;
+    int32_t capacity;
+    uint32_t appointmentCount;
+    uint32_t waitingCount;
+};
+
+struct SnapshotAppointment{
+    uint32_t patientID, patientName;
+    int32_t priorityLevel;
+    int32_t triageOrder;
+};
+
+struct SnapshotWaiting{
+    uint32_t patientID, patientName;
+    int32_t priorityLevel;
+};
+
+// 64-bit FNV-1a folded over 8-byte words; corruption check, not security.
+inline uint64_t snapshotChecksum(const char* data, size_t size){
+    uint64_t h = 1469598103934665603ULL;
+    size_t i = 0;
+    for(; i + 8 <= size; i += 8){
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        h = (h ^ word) * 1099511628211ULL;
+    };
+    for(; i < size; i++){
+        h = (h ^ static_cast<unsigned char>(data[i])) * 1099511628211ULL;
+    };
+    return h;
+}
+
+// Assigns each distinct string (IDs, names, time slots) one index so it is
+// stored once no matter how many records refer to it.
+class SnapshotStringTable{
+    private:
+        std::unordered_map<std::string, uint32_t> index;
+        std::vector<uint32_t> offsets;
+        std::string bytes;
+    public:
+        SnapshotStringTable() : offsets(1, 0) {};
+        uint32_t intern(const std::string& s){
+            auto it = index.find(s);
+            if(it != index.end()) return it->second;
+            uint32_t id = static_cast<uint32_t>(offsets.size() - 1);
+            index.emplace(s, id);
+            bytes += s;
+            offsets.push_back(static_cast<uint32_t>(bytes.size()));
+            return id;
+        };
+        uint32_t size() const { return static_cast<uint32_t>(offsets.size() - 1); };
+        const std::vector<uint32_t>& getOffsets() const { return offsets; };
+        const std::string& getBytes() const { return bytes; };
+};
+
+// Bounds-checked cursor over a loaded payload.
+class SnapshotReader{
+    private:
+        const char* data;
+        size_t size;
+        size_t pos;
+    public:
+        SnapshotReader(const char* d, size_t n) : data(d), size(n), pos(0) {};
+        template <typename T>
+        bool read(std::vector<T>& out, size_t count){
+            if(count > (size - pos) / sizeof(T)) return false;
+            out.resize(count);
+            if(count) std::memcpy(out.data(), data + pos, count * sizeof(T));
+            pos += count * sizeof(T);
+            return true;
+        };
+        template <typename T>
+        bool read(T& out){
+            if(sizeof(T) > size - pos) return false;
+            std::memcpy(&out, data + pos, sizeof(T));
+            pos += sizeof(T);
+            return true;
+        };
+        bool readBytes(std::string_view& out, size_t count){
+            if(count > size - pos) return false;
+            out = std::string_view(data + pos, count);
+            pos += count;
+            return true;
+        };
+        bool atEnd() const { return pos == size; };
+};
+
+#endif
@@ -0,0 +1,136 @@
+#ifndef HOSPITALSTATUS_H
+#define HOSPITALSTATUS_H
+
+#include <string>
+#include "Patient.h"
+#include "TriageEntry.h"
+
+// Outcomes of HospitalSystem operations, returned instead of printed so
+// callers can report or retry; ConsoleEventSink turns them into the menu's
+// messages.
+enum ScheduleStatus {
+    SCHEDULE_BOOKED,           // appointment made
+    SCHEDULE_WAITLISTED,       // slot full, patient put on its waiting list
+    SCHEDULE_WAITLIST_FULL,    // slot and its waiting list both full
+    SCHEDULE_DOCTOR_NOT_FOUND,
+    SCHEDULE_INVALID_TIME,
+    SCHEDULE_ALREADY_BOOKED,   // patient holds a place at that time already
+    SCHEDULE_NO_FREE_SLOT,     // auto-assign: no doctor of the specialty has room
+    SCHEDULE_NOT_OFFERED,      // the doctor's availability has no slot at that time
+    SCHEDULE_NAMES_FULL        // the intern table has no room for a new ID or name
+};
+
+inline const char* scheduleStatusText(ScheduleStatus s){
+    switch(s){
+        case SCHEDULE_BOOKED:           return "Appointment scheduled.";
+        case SCHEDULE_WAITLISTED:       return "Slot full. Added to waiting list.";
+        case SCHEDULE_WAITLIST_FULL:    return "Waiting List is Full .We can't add!";
+        case SCHEDULE_DOCTOR_NOT_FOUND: return "Doctor not found.";
+        case SCHEDULE_INVALID_TIME:     return "Invalid time slot.";
+        case SCHEDULE_ALREADY_BOOKED:   return "Patient is already booked at this time.";
+        case SCHEDULE_NO_FREE_SLOT:     return "No free slot for this specialty.";
+        case SCHEDULE_NOT_OFFERED:      return "The doctor does not work at this time.";
+        case SCHEDULE_NAMES_FULL:       return "No room for new patients.";
+    };
+    return "";
+}
+
+enum DoctorStatus {
+    DOCTOR_ADDED,
+    DOCTOR_EXISTS
+};
+
+enum AvailabilityStatus {
+    AVAILABILITY_ADDED,
+    AVAILABILITY_DOCTOR_NOT_FOUND,
+    AVAILABILITY_INVALID        // no weekdays, empty time range, step or capacity < 1
+};
+
+enum CancelStatus {
+    CANCEL_DONE,
+    CANCEL_DOCTOR_NOT_FOUND,
+    CANCEL_SLOT_NOT_FOUND,
+    CANCEL_NOT_FOUND           // no such appointment in the slot
+};
+
+enum CallStatus {
+    CALL_DONE,
+    CALL_DOCTOR_NOT_FOUND,
+    CALL_QUEUE_EMPTY,
+    CALL_NO_VALID_PATIENT      // queue held only cancelled or called entries
+};
+
+// Upper-case names of the statuses, for machine-readable output (the
+// command stream's responses, the history export).
+inline const char* scheduleStatusName(ScheduleStatus s){
+    switch(s){
+        case SCHEDULE_BOOKED:           return "BOOKED";
+        case SCHEDULE_WAITLISTED:       return "WAITLISTED";
+        case SCHEDULE_WAITLIST_FULL:    return "WAITLIST_FULL";
+        case SCHEDULE_DOCTOR_NOT_FOUND: return "DOCTOR_NOT_FOUND";
+        case SCHEDULE_INVALID_TIME:     return "INVALID_TIME";
+        case SCHEDULE_ALREADY_BOOKED:   return "ALREADY_BOOKED";
+        case SCHEDULE_NO_FREE_SLOT:     return "NO_FREE_SLOT";
+        case SCHEDULE_NOT_OFFERED:      return "NOT_OFFERED";
+        case SCHEDULE_NAMES_FULL:       return "NAMES_FULL";
+    };
+    return "";
+}
+
+inline const char* doctorStatusName(DoctorStatus s){
+    return s == DOCTOR_ADDED ? "ADDED" : "EXISTS";
+}
+
+inline const char* cancelStatusName(CancelStatus s){
+    switch(s){
+        case CANCEL_DONE:             return "CANCELLED";
+        case CANCEL_DOCTOR_NOT_FOUND: return "DOCTOR_NOT_FOUND";
+        case CANCEL_SLOT_NOT_FOUND:   return "SLOT_NOT_FOUND";
+        case CANCEL_NOT_FOUND:        return "NOT_FOUND";
+    };
+    return "";
+}
+
+inline const char* callStatusName(CallStatus s){
+    switch(s){
+        case CALL_DONE:             return "CALLED";
+        case CALL_DOCTOR_NOT_FOUND: return "DOCTOR_NOT_FOUND";
+        case CALL_QUEUE_EMPTY:      return "QUEUE_EMPTY";
+        case CALL_NO_VALID_PATIENT: return "NO_VALID_PATIENT";
+    };
+    return "";
+}
+
+inline const char* availabilityStatusName(AvailabilityStatus s){
+    switch(s){
+        case AVAILABILITY_ADDED:            return "ADDED";
+        case AVAILABILITY_DOCTOR_NOT_FOUND: return "DOCTOR_NOT_FOUND";
+        case AVAILABILITY_INVALID:          return "INVALID";
+    };
+    return "";
+}
+
+struct ScheduleRequest{
+    Patient patient;
+    std::string doctorID;
+    std::string timeSlot;
+};
+
+struct ScheduleResult{
+    ScheduleStatus status;
+    std::string clashDoctorID; // for SCHEDULE_ALREADY_BOOKED: where the patient is
+    bool clashWaitlisted;      // ...and whether on that slot's waiting list
+};
+
+struct AssignResult{
+    ScheduleResult result;
+    std::string doctorID; // doctor and slot that were chosen
+    std::string timeSlot;
+};
+
+struct CallResult{
+    CallStatus status;
+    TriageEntry patient; // for CALL_DONE: who was called
+};
+
+#endif
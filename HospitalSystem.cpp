@@ -1,29 +1,167 @@
 #include "HospitalSystem.h"
-
-HospitalSystem::HospitalSystem() : triageOrderCounter(0) {
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+HospitalSystem::HospitalSystem(int day)
+: today(day), triageOrderCounter(0), journal("appointments.journal"), events(&nullEvents) {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_LOAD);
+    // A collect from another system in the process waits for the registry,
+    // so it marks these records only once they are loaded.
+    namesRoot = names().addRoot([this](const InternTable::Mark& mark) { markNames(mark); });
+    std::unique_lock<std::shared_mutex> registry(registryMutex);
     loadDoctorsFromFile();
+    loadAvailabilityFromFile();
     loadAppointmentsFromFile();
+    for (const auto& dPair : doctors)
+        publishView(dPair.second);
+    publishDirectory();
+}
+
+HospitalSystem::~HospitalSystem() {
+    names().removeRoot(namesRoot);
+}
+
+void HospitalSystem::markNames(const InternTable::Mark& mark) const {
+    std::shared_lock<std::shared_mutex> registry(registryMutex);
+    for (const auto& dPair : doctors) {
+        const DoctorShard& shard = dPair.second;
+        std::lock_guard<std::mutex> guard(shard.lock);
+        mark(shard.doctorKey);
+        for (const TimeSlotInfo& slot : shard.doctor.getSchedule()) {
+            for (const auto& a : slot.getAppointments()) {
+                mark(a.getPatientKey());
+                mark(a.getPatientNameKey());
+            }
+            for (const Patient& p : slot.getWaitingList()) {
+                mark(p.getpIDKey());
+                mark(p.getnamePatKey());
+            }
+        }
+        // Stale entries too: their IDs are still compared against slots.
+        shard.triage.forEach([&mark](const TriageEntry& e) {
+            mark(e.patientID);
+            mark(e.patientName);
+        });
+    }
 }
 
 bool HospitalSystem::isValidTime(const std::string& time) const {
-    if (time.length() != 5 || time[2] != ':') return false;
-    if (!isdigit(time[0]) || !isdigit(time[1]) ||
-        !isdigit(time[3]) || !isdigit(time[4])) return false;
+    return parseSlot(time) >= 0;
+}
+
+int HospitalSystem::parseSlot(const std::string& timeSlot) const {
+    // A bare "HH:MM" is today; earlier days are closed.
+    int day = today;
+    int key = parseSlotTime(timeSlot, day);
+    return key >= 0 && slotDay(key) >= day ? key : -1;
+}
 
-    int hours = (time[0]-'0')*10 + (time[1]-'0');
-    int minutes = (time[3]-'0')*10 + (time[4]-'0');
+DoctorStatus HospitalSystem::addDoctor(const Doctor& d) {
+    std::unique_lock<std::shared_mutex> registry(registryMutex);
+    DoctorStatus status = DOCTOR_EXISTS;
+    if (!doctors.count(d.getdID())) {
+        publishView(addDoctorShard(d)); // not in the directory yet, so no reader
+        publishDirectory();
+        appendDoctorToFile(d);
+        for (const AvailabilityRule& rule : d.getAvailability().getRules())
+            appendAvailabilityToFile(d.getdID(), rule);
+        status = DOCTOR_ADDED;
+    }
+    emit({EVENT_DOCTOR_ADDED, status, d.getdID(), {}, {}, {}, 0, {}, false});
+    return status;
+}
 
-    return hours >= 0 && hours < 24 && minutes >= 0 && minutes < 60;
+void HospitalSystem::publishDirectory() {
+    auto all = std::make_shared<DoctorDirectory>();
+    all->reserve(doctors.size());
+    for (const auto& dPair : doctors)
+        all->push_back({&dPair.first, &dPair.second});
+    std::atomic_store(&directory, std::shared_ptr<const DoctorDirectory>(std::move(all)));
 }
 
-void HospitalSystem::addDoctor(const Doctor& d) {
-    if(doctors.count(d.getdID())){
-        std::cout<<"Doctor ID is exists"<<std::endl;
-        return;
+std::shared_ptr<const DoctorView> HospitalSystem::getDoctorView(const std::string& doctorID) const {
+    std::shared_ptr<const DoctorDirectory> all = std::atomic_load(&directory);
+    const DoctorShard* shard = all ? findInDirectory(*all, doctorID) : nullptr;
+    return shard ? currentView(*shard) : nullptr;
+}
+
+void HospitalSystem::setEventSink(HospitalEventSink* sink) {
+    events = sink ? sink : &nullEvents;
+}
+
+void HospitalSystem::emit(HospitalEvent e) const {
+    e.day = today;
+    events.load()->onEvent(e);
+}
+
+void HospitalSystem::emitScheduled(const ScheduleResult& r, const Patient& p,
+                                   const std::string& doctorID, const std::string& timeSlot) const {
+    emit({EVENT_SCHEDULED, r.status, doctorID, timeSlot, p.getpID(), p.getnamePat(),
+          p.getpriLevel(), r.clashDoctorID, r.clashWaitlisted});
+}
+
+DoctorShard& HospitalSystem::addDoctorShard(const Doctor& d) {
+    auto inserted = doctors.try_emplace(d.getdID(), d);
+    DoctorShard& shard = inserted.first->second;
+    if (inserted.second) {
+        shard.triage.setPolicy(triagePolicy);
+        shard.joinSpecialty(&specialties[d.getdSpecialty()]);
+        if (!d.getAvailability().empty())
+            shard.specialty->withAvailability.push_back(&shard);
+        // A doctor may arrive with slots already set up.
+        for (const TimeSlotInfo& slot : shard.doctor.getSchedule()) {
+            shard.adjust(static_cast<int>(slot.getAppointmentCount()), slot.getCapacity(),
+                         static_cast<int>(slot.getWaitingList().size()));
+            shard.slotChanged(slot);
+        }
     }
-    doctors.emplace(d.getdID(), d);
-    appendDoctorToFile(d);
-    std::cout<<"Doctor added successfully."<<std::endl;
+    return shard;
+}
+
+void HospitalSystem::recountSchedules() {
+    for (auto& dPair : doctors) {
+        DoctorShard& shard = dPair.second;
+        shard.resetLoad();
+        for (const TimeSlotInfo& slot : shard.doctor.getSchedule()) {
+            shard.adjust(static_cast<int>(slot.getAppointmentCount()), slot.getCapacity(),
+                         static_cast<int>(slot.getWaitingList().size()));
+            shard.slotChanged(slot);
+        }
+    }
+}
+
+AvailabilityStatus HospitalSystem::addAvailability(const std::string& doctorID,
+                                                   const AvailabilityRule& rule) {
+    // Exclusive: the specialty's list of doctors with availability changes.
+    std::unique_lock<std::shared_mutex> registry(registryMutex);
+    auto it = doctors.find(doctorID);
+    if (it == doctors.end()) return AVAILABILITY_DOCTOR_NOT_FOUND;
+    if (!rule.valid()) return AVAILABILITY_INVALID;
+    {
+        ShardGuard guard(it->second);
+        addAvailabilityLocked(it->second, rule);
+    }
+    appendAvailabilityToFile(doctorID, rule);
+    return AVAILABILITY_ADDED;
+}
+
+void HospitalSystem::addAvailabilityLocked(DoctorShard& shard, const AvailabilityRule& rule) {
+    if (shard.doctor.getAvailability().empty())
+        shard.specialty->withAvailability.push_back(&shard);
+    shard.doctor.addAvailability(rule);
+    shard.rulesChanged();
+}
+
+void HospitalSystem::appendAvailabilityToFile(const std::string& doctorID,
+                                              const AvailabilityRule& rule) const {
+    std::ofstream out("availability.txt", std::ios::app);
+    out << doctorID << " "
+        << formatWeekdays(rule.weekdays) << " "
+        << formatClock(rule.from) << " "
+        << formatClock(rule.to) << " "
+        << rule.step << " "
+        << rule.capacity << "\n";
 }
 
 void HospitalSystem::appendDoctorToFile(const Doctor& d) const {
@@ -34,297 +172,1246 @@ void HospitalSystem::appendDoctorToFile(const Doctor& d) const {
 }
 
 void HospitalSystem::listDoctors() const {
-    if (doctors.empty()) {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_LIST_DOCTORS);
+    std::shared_ptr<const DoctorDirectory> all = std::atomic_load(&directory);
+    if (!all || all->empty()) {
         std::cout << "No doctors in the system.\n";
         return;
     }
-    for (const auto& p : doctors) {
-        std::cout << p.second.getdID() << " | "
-                  << p.second.getdName() << " | "
-                  << p.second.getdSpecialty()
-                  << " | Appointments: ";
-
-        int total = 0;
-        for (const auto& s : p.second.getSchedule())
-            total += s.second.getAppointments().size();
-
-        std::cout << total << "\n";
+    // Names never change and the count is a mirror, so no view is needed.
+    for (const auto& entry : *all) {
+        const Doctor& d = entry.second->doctor;
+        std::cout << *entry.first << " | "
+                  << d.getdName() << " | "
+                  << d.getdSpecialty()
+                  << " | Appointments: " << entry.second->booked.load(std::memory_order_relaxed) << "\n";
     }
 }
 
 void HospitalSystem::viewDoctorSchedule(const std::string& doctorID) const {
-    auto it = doctors.find(doctorID);
-    if (it == doctors.end()) {
+    std::shared_ptr<const DoctorView> d = getDoctorView(doctorID);
+    if (!d) {
         std::cout << "Doctor not found.\n";
         return;
     }
-    if (it->second.getSchedule().empty()) {
+    for (const AvailabilityRule& rule : d->rules) {
+        std::cout << "Available " << formatWeekdays(rule.weekdays) << " " << formatClock(rule.from)
+                  << "-" << formatClock(rule.to) << " every " << rule.step << " min, capacity "
+                  << rule.capacity << "\n";
+    }
+    if (d->days.empty()) {
         std::cout << "No schedule available for this doctor.\n";
         return;
     }
 
-    it->second.printSchedule();
+    for (const auto& day : d->days) {
+        for (const SlotView& s : day->slots)
+            printSlotView(*day, s);
+    }
 }
 
-void HospitalSystem::scheduleAppointment(const Patient& p,
-                                        const std::string& doctorID,
-                                        const std::string& timeSlot) {
-
-    auto it = doctors.find(doctorID);
-    if (it == doctors.end()) {
+void HospitalSystem::viewDoctorSchedule(const std::string& doctorID,
+                                       const std::string& from,
+                                       const std::string& to) const {
+    std::shared_ptr<const DoctorView> d = getDoctorView(doctorID);
+    if (!d) {
         std::cout << "Doctor not found.\n";
         return;
     }
+    // Only the days between the two times are looked at.
+    int fromMinute = parseSlotTime(from, today), toMinute = parseSlotTime(to, today);
+    if (fromMinute < 0 || toMinute < 0) {
+        std::cout << "Time format must be HH:MM or YYYY-MM-DDTHH:MM\n";
+        return;
+    }
+    bool any = false;
+    auto day = std::lower_bound(d->days.begin(), d->days.end(), slotDay(fromMinute),
+                                [](const std::shared_ptr<const DayView>& v, int k) { return v->day < k; });
+    for (; day != d->days.end() && (*day)->day <= slotDay(toMinute); ++day) {
+        for (const SlotView& s : (*day)->slots) {
+            if (s.key < fromMinute || s.key > toMinute) continue;
+            printSlotView(**day, s);
+            any = true;
+        }
+    }
+    if (!any)
+        std::cout << "No slots between " << from << " and " << to << ".\n";
+}
 
-    TimeSlotInfo* slot = it->second.getTimeSlot(timeSlot);
-    if (!slot) {
-        // Auto-create a new timeslot with default capacity 2 when missing
-        it->second.addTimeSlot(timeSlot, 2);
-        slot = it->second.getTimeSlot(timeSlot);
+ScheduleResult HospitalSystem::bookLocked(DoctorShard& shard, const Patient& p,
+                                          const std::string& timeSlot, int minute,
+                                          JournalBatch* batch) {
+    const std::string& doctorID = shard.doctor.getdID();
+    TimeSlotInfo* slot = shard.doctor.getTimeSlot(minute);
+    bool full = slot && slot->isFullAppointments();
+    int capacity = slot ? slot->getCapacity() : shard.doctor.capacityFor(minute);
+    if (capacity == 0)
+        return {SCHEDULE_NOT_OFFERED, "", false};
+
+    // Rejected before anything is recorded, so the patient's strings are
+    // not interned; a place at the same time elsewhere is still the reason
+    // given first.
+    PatientLocation clash;
+    if (full && slot->isFullWaitingList()) {
+        NameId known;
+        if (names().find(p.getpID(), known) && patientIndex.holds(known, minute, &clash))
+            return {SCHEDULE_ALREADY_BOOKED, names().str(clash.doctorID), clash.waitlisted};
+        return {SCHEDULE_WAITLIST_FULL, "", false};
     }
 
-    Appointment a(doctorID, p.getpID(), p.getnamePat(), timeSlot, p.getpriLevel());
+    // One place per patient per time, across all doctors and waiting lists;
+    // checked and recorded atomically so two desks cannot both succeed. A
+    // clash means the ID was interned already.
+    NameId patient = names().intern(p.getpID());
+    if (patient == NO_NAME)
+        return {SCHEDULE_NAMES_FULL, "", false};
+    if (!patientIndex.reserve(patient, shard.doctorKey, minute, full, &clash))
+        return {SCHEDULE_ALREADY_BOOKED, names().str(clash.doctorID), clash.waitlisted};
+    NameId name = names().intern(p.getnamePat());
+    if (name == NO_NAME) {
+        patientIndex.remove(patient, shard.doctorKey, minute, full);
+        return {SCHEDULE_NAMES_FULL, "", false};
+    }
 
-    if (slot->addAppointment(a)) {
-        triageQueue.push({p.getpriLevel(), p.getpID(), p.getnamePat(),
-                          doctorID, timeSlot, triageOrderCounter++});
+    if (!slot) {
+        // First booking of the slot: create it with the capacity the
+        // doctor's availability gives it (2 for a doctor without any).
+        slot = shard.doctor.addTimeSlot(minute, capacity);
+        shard.adjust(0, slot->getCapacity(), 0);
+    }
 
-        std::cout << "Appointment scheduled.\n";
+    JournalOp op = full ? JOURNAL_WAITLIST : JOURNAL_SCHEDULE;
+    if (!full) {
+        int order = triageOrderCounter++;
+        slot->addAppointment(Appointment(patient, name, p.getpriLevel(), order));
+        shard.triage.push({p.getpriLevel(), patient, name, shard.doctorKey, minute, order});
+        shard.adjust(1, 0, 0);
     } else {
-        slot->addToWaitingList(p);
-        std::cout << "Slot full. Added to waiting list.\n";
+        slot->addToWaitingList(Patient(patient, name, p.getpriLevel()));
+        shard.adjust(0, 0, 1);
     }
-    rewriteAppointmentsFile();
+    shard.slotChanged(*slot);
+
+    if (batch)
+        batch->add(op, doctorID, timeSlot, p.getpID(), p.getnamePat(), p.getpriLevel());
+    else
+        journal.append(op, doctorID, timeSlot, p.getpID(), p.getnamePat(), p.getpriLevel());
+    return {full ? SCHEDULE_WAITLISTED : SCHEDULE_BOOKED, "", false};
+}
+
+ScheduleResult HospitalSystem::scheduleAppointment(const Patient& p,
+                                                  const std::string& doctorID,
+                                                  const std::string& timeSlot) {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_SCHEDULE);
+    ScheduleResult r{SCHEDULE_DOCTOR_NOT_FOUND, "", false};
+    {
+        std::shared_lock<std::shared_mutex> registry(registryMutex);
+        auto it = doctors.find(doctorID);
+        int minute = parseSlot(timeSlot);
+        if (it == doctors.end() || minute < 0) {
+            if (it != doctors.end()) r.status = SCHEDULE_INVALID_TIME;
+            emitScheduled(r, p, doctorID, timeSlot);
+            return r;
+        }
+
+        // Journaled and reported with its date, whatever form it came in.
+        std::string slotText = formatSlotTime(minute);
+        ShardGuard guard(it->second);
+        r = bookLocked(it->second, p, slotText, minute, nullptr);
+        emitScheduled(r, p, doctorID, slotText);
+    }
+    compactIfNeeded();
+    return r;
+}
+
+std::vector<ScheduleResult> HospitalSystem::scheduleAppointments(const std::vector<ScheduleRequest>& batch) {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_SCHEDULE_BATCH);
+    std::vector<ScheduleResult> results(batch.size(), ScheduleResult{SCHEDULE_INVALID_TIME, "", false});
+
+    // Validate, then group by doctor; within a doctor, items for the same
+    // slot stay in request order so earlier requests get the free places.
+    std::vector<int> minutes(batch.size());
+    std::vector<std::string> slotTexts(batch.size());
+    std::map<std::string, std::vector<size_t>> byDoctor;
+    for (size_t i = 0; i < batch.size(); i++) {
+        minutes[i] = parseSlot(batch[i].timeSlot);
+        if (minutes[i] >= 0) {
+            slotTexts[i] = formatSlotTime(minutes[i]);
+            byDoctor[batch[i].doctorID].push_back(i);
+        }
+    }
+
+    {
+        std::shared_lock<std::shared_mutex> registry(registryMutex);
+        JournalBatch journaled;
+        // Every doctor touched stays locked until the batch is journaled, so
+        // no other operation on them can reach the journal ahead of it.
+        // Locks are taken in map order, which keeps concurrent batches from
+        // deadlocking each other.
+        std::vector<ShardGuard> held;
+
+        for (auto& group : byDoctor) {
+            auto it = doctors.find(group.first);
+            if (it == doctors.end()) {
+                for (size_t i : group.second)
+                    results[i].status = SCHEDULE_DOCTOR_NOT_FOUND;
+                continue;
+            }
+            held.emplace_back(it->second);
+            std::stable_sort(group.second.begin(), group.second.end(),
+                             [&minutes](size_t a, size_t b) { return minutes[a] < minutes[b]; });
+            for (size_t i : group.second) {
+                results[i] = bookLocked(it->second, batch[i].patient, slotTexts[i],
+                                        minutes[i], &journaled);
+                emitScheduled(results[i], batch[i].patient, batch[i].doctorID, slotTexts[i]);
+            }
+        }
+        journal.commit(journaled);
+    }
+    for (size_t i = 0; i < batch.size(); i++) {
+        if (results[i].status == SCHEDULE_INVALID_TIME || results[i].status == SCHEDULE_DOCTOR_NOT_FOUND)
+            emitScheduled(results[i], batch[i].patient, batch[i].doctorID, batch[i].timeSlot);
+    }
+    compactIfNeeded();
+    return results;
 }
 
 void HospitalSystem::rewriteAppointmentsFile() const {
-    std::ofstream out("appointments.txt");
+    // Written next to the live file and renamed over it, so a crash during
+    // compaction never leaves a half-written appointments.txt behind.
+    FILE* out = std::fopen("appointments.txt.tmp", "w");
+    if (!out) return;
 
     for (const auto& dPair : doctors) {
-        const Doctor& d = dPair.second;
+        const Doctor& d = dPair.second.doctor;
 
-        for (const auto& sPair : d.getSchedule()) {
-            const std::string& ts = sPair.first;
-            const TimeSlotInfo& slot = sPair.second;
+        for (const TimeSlotInfo& slot : d.getSchedule()) {
+            const std::string ts = slot.getTimeSlot();
 
             for (const auto& a : slot.getAppointments()) {
-                out << d.getdID() << " "
-                    << ts << " "
-                    << a.getPatientID() << " "
-                    << a.getPatientName() << " "
-                    << a.getPriorityLevel() << "\n";
+                std::fprintf(out, "%s %s %s %s %d\n",
+                             d.getdID().c_str(), ts.c_str(),
+                             a.getPatientID().c_str(),
+                             a.getPatientName().c_str(),
+                             a.getPriorityLevel());
             }
         }
     }
+    std::fflush(out);
+    fsync(fileno(out));
+    std::fclose(out);
+    std::rename("appointments.txt.tmp", "appointments.txt");
 }
 
-void HospitalSystem::cancelAppointment(const std::string& doctorID,
-                                      const std::string& timeSlot,
-                                      const std::string& patientID) {
+void HospitalSystem::compactIfNeeded() {
+    // Called with no locks held: compaction needs every booking to be quiet,
+    // which the exclusive registry lock guarantees (reports may still read).
+    if (!journal.needsCompaction()) return;
+    std::unique_lock<std::shared_mutex> registry(registryMutex);
+    if (journal.needsCompaction()) // another thread may have compacted meanwhile
+        compactLocked();
+}
 
-    auto it = doctors.find(doctorID);
-    if (it == doctors.end()) {
-        std::cout << "Doctor not found.\n";
-        return;
-    }
+void HospitalSystem::saveSnapshot() {
+    std::unique_lock<std::shared_mutex> registry(registryMutex);
+    compactLocked();
+}
 
-    TimeSlotInfo* slot = it->second.getTimeSlot(timeSlot);
-    if (!slot){
-        std::cout << "Time slot not found.\n";
-        return;
+void HospitalSystem::compactLocked() {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_COMPACTION);
+    // appointments.txt stays as the readable fallback; hospital.snapshot is
+    // what startup prefers. Both cover the current journal epoch, after which
+    // a fresh journal is started.
+    rewriteAppointmentsFile();
+    writeSnapshotFile(journal.getEpoch());
+    journal.reset(journal.getEpoch() + 1);
+}
+
+void HospitalSystem::writeSnapshotFile(int journalEpoch) const {
+    SnapshotStringTable strings;
+    std::vector<SnapshotDoctor> doctorRecords;
+    std::vector<SnapshotSlot> slotRecords;
+    std::vector<SnapshotAppointment> appointmentRecords;
+    std::vector<SnapshotWaiting> waitingRecords;
+
+    for (const auto& dPair : doctors) {
+        const Doctor& d = dPair.second.doctor;
+        doctorRecords.push_back({strings.intern(d.getdID()), strings.intern(d.getdName()),
+                                 strings.intern(d.getdSpecialty()),
+                                 static_cast<uint32_t>(d.getSchedule().size())});
+
+        for (const TimeSlotInfo& slot : d.getSchedule()) {
+            slotRecords.push_back({strings.intern(slot.getTimeSlot()), slot.getCapacity(),
+                                   static_cast<uint32_t>(slot.getAppointmentCount()),
+                                   static_cast<uint32_t>(slot.getWaitingList().size())});
+
+            for (const auto& a : slot.getAppointments()) {
+                appointmentRecords.push_back({strings.intern(a.getPatientID()),
+                                              strings.intern(a.getPatientName()),
+                                              a.getPriorityLevel(), a.getTriageOrder()});
+            }
+            for (const Patient& p : slot.getWaitingList()) {
+                waitingRecords.push_back({strings.intern(p.getpID()),
+                                          strings.intern(p.getnamePat()), p.getpriLevel()});
+            }
+        }
     }
 
-    if (!slot->removeAppointmentByPatientID(patientID)) {
-        std::cout << "Appointment not found.\n";
-        return;
+    SnapshotCounts counts = {
+        journalEpoch, triageOrderCounter.load(), strings.size(),
+        static_cast<uint32_t>(strings.getBytes().size()),
+        static_cast<uint32_t>(doctorRecords.size()),
+        static_cast<uint32_t>(slotRecords.size()),
+        static_cast<uint32_t>(appointmentRecords.size()),
+        static_cast<uint32_t>(waitingRecords.size())
+    };
+
+    std::string payload;
+    payload.append(reinterpret_cast<const char*>(&counts), sizeof(counts));
+    payload.append(reinterpret_cast<const char*>(strings.getOffsets().data()),
+                   strings.getOffsets().size() * sizeof(uint32_t));
+    payload.append(strings.getBytes());
+    payload.append(reinterpret_cast<const char*>(doctorRecords.data()),
+                   doctorRecords.size() * sizeof(SnapshotDoctor));
+    payload.append(reinterpret_cast<const char*>(slotRecords.data()),
+                   slotRecords.size() * sizeof(SnapshotSlot));
+    payload.append(reinterpret_cast<const char*>(appointmentRecords.data()),
+                   appointmentRecords.size() * sizeof(SnapshotAppointment));
+    payload.append(reinterpret_cast<const char*>(waitingRecords.data()),
+                   waitingRecords.size() * sizeof(SnapshotWaiting));
+
+    SnapshotHeader header;
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.reserved = 0;
+    header.payloadSize = payload.size();
+    header.checksum = snapshotChecksum(payload.data(), payload.size());
+
+    FILE* out = std::fopen("hospital.snapshot.tmp", "wb");
+    if (!out) return;
+    std::fwrite(&header, sizeof(header), 1, out);
+    std::fwrite(payload.data(), 1, payload.size(), out);
+    std::fflush(out);
+    fsync(fileno(out));
+    std::fclose(out);
+    std::rename("hospital.snapshot.tmp", "hospital.snapshot");
+}
+
+bool HospitalSystem::loadSnapshotFile(int& journalEpoch, int keepFrom, DayArchive& archive) {
+    MappedFile file("hospital.snapshot");
+    if (!file.isOpen()) return false;
+
+    std::string_view data = file.view();
+    SnapshotHeader header;
+    if (data.size() < sizeof(header)) {
+        std::cerr << "hospital.snapshot is truncated; loading appointments.txt instead.\n";
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    data.remove_prefix(sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != SNAPSHOT_VERSION) {
+        std::cerr << "hospital.snapshot has an unknown format; loading appointments.txt instead.\n";
+        return false;
+    }
+    if (header.payloadSize != data.size() ||
+        header.checksum != snapshotChecksum(data.data(), data.size())) {
+        std::cerr << "hospital.snapshot failed its checksum; loading appointments.txt instead.\n";
+        return false;
     }
 
-    std::cout << "Appointment cancelled.\n";
+    SnapshotReader reader(data.data(), data.size());
+    SnapshotCounts counts;
+    std::vector<uint32_t> offsets;
+    std::string_view bytes;
+    std::vector<SnapshotDoctor> doctorRecords;
+    std::vector<SnapshotSlot> slotRecords;
+    std::vector<SnapshotAppointment> appointmentRecords;
+    std::vector<SnapshotWaiting> waitingRecords;
+    bool ok = reader.read(counts) &&
+              reader.read(offsets, size_t(counts.strings) + 1) &&
+              reader.readBytes(bytes, counts.stringBytes) &&
+              reader.read(doctorRecords, counts.doctors) &&
+              reader.read(slotRecords, counts.slots) &&
+              reader.read(appointmentRecords, counts.appointments) &&
+              reader.read(waitingRecords, counts.waiting) &&
+              reader.atEnd();
+
+    // A matching checksum does not prove the writer was sane; validate every
+    // index before touching any state so a bad file changes nothing.
+    std::vector<std::string> strings;
+    if (ok) {
+        strings.reserve(counts.strings);
+        for (uint32_t i = 0; ok && i < counts.strings; i++) {
+            ok = offsets[i] <= offsets[i + 1] && offsets[i + 1] <= counts.stringBytes;
+            if (ok) strings.emplace_back(bytes.substr(offsets[i], offsets[i + 1] - offsets[i]));
+        }
+    }
+    uint64_t slotTotal = 0, appointmentTotal = 0, waitingTotal = 0;
+    for (size_t i = 0; ok && i < doctorRecords.size(); i++) {
+        const SnapshotDoctor& d = doctorRecords[i];
+        ok = d.id < counts.strings && d.name < counts.strings && d.specialty < counts.strings;
+        slotTotal += d.slotCount;
+    }
+    for (size_t i = 0; ok && i < slotRecords.size(); i++) {
+        ok = slotRecords[i].timeSlot < counts.strings && slotRecords[i].capacity >= 0 &&
+             parseSlotTime(strings[slotRecords[i].timeSlot], today) >= 0;
+        appointmentTotal += slotRecords[i].appointmentCount;
+        waitingTotal += slotRecords[i].waitingCount;
+    }
+    for (size_t i = 0; ok && i < appointmentRecords.size(); i++)
+        ok = appointmentRecords[i].patientID < counts.strings &&
+             appointmentRecords[i].patientName < counts.strings;
+    for (size_t i = 0; ok && i < waitingRecords.size(); i++)
+        ok = waitingRecords[i].patientID < counts.strings &&
+             waitingRecords[i].patientName < counts.strings;
+    ok = ok && slotTotal == counts.slots && appointmentTotal == counts.appointments &&
+         waitingTotal == counts.waiting;
+    if (!ok) {
+        std::cerr << "hospital.snapshot is inconsistent; loading appointments.txt instead.\n";
+        return false;
+    }
 
-    if (!slot->getWaitingList().empty()) {
-        Patient p = slot->popFromWaitingList();
-        Appointment a(doctorID, p.getpID(), p.getnamePat(), timeSlot, p.getpriLevel());
-        slot->addAppointment(a);
+    // The snapshot's own string table maps straight onto interned names;
+    // strings only used by archived days are never interned.
+    std::vector<NameId> ids(strings.size(), NO_NAME);
+    auto idOf = [&](uint32_t i) {
+        if (ids[i] == NO_NAME) ids[i] = names().intern(strings[i]);
+        return ids[i];
+    };
+
+    std::map<std::string, std::vector<TriageEntry>> loadedEntries;
+    size_t nextSlot = 0, nextAppointment = 0, nextWaiting = 0;
+    for (const SnapshotDoctor& dr : doctorRecords) {
+        const std::string& doctorID = strings[dr.id];
+        DoctorShard& shard = addDoctorShard(Doctor(doctorID, strings[dr.name],
+                                                   strings[dr.specialty]));
+        Doctor& d = shard.doctor;
+        std::vector<TriageEntry>& entries = loadedEntries[doctorID];
+
+        for (uint32_t s = 0; s < dr.slotCount; s++) {
+            const SnapshotSlot& sr = slotRecords[nextSlot++];
+            const std::string& timeSlot = strings[sr.timeSlot];
+            int minute = parseSlotTime(timeSlot, today);
+            if (slotDay(minute) < keepFrom) {
+                for (uint32_t k = 0; k < sr.appointmentCount; k++) {
+                    const SnapshotAppointment& ar = appointmentRecords[nextAppointment++];
+                    archive.append(doctorID, timeSlot, strings[ar.patientID], strings[ar.patientName],
+                                   ar.priorityLevel);
+                }
+                nextWaiting += sr.waitingCount;
+                archive.slotArchived();
+                continue;
+            }
+            TimeSlotInfo* slot = d.addTimeSlot(minute, sr.capacity);
+
+            for (uint32_t k = 0; k < sr.appointmentCount; k++) {
+                const SnapshotAppointment& ar = appointmentRecords[nextAppointment++];
+                NameId patient = idOf(ar.patientID), name = idOf(ar.patientName);
+                if (slot->addAppointment(Appointment(patient, name, ar.priorityLevel, ar.triageOrder))) {
+                    entries.push_back({ar.priorityLevel, patient, name, shard.doctorKey, minute,
+                                       ar.triageOrder});
+                    patientIndex.add(patient, shard.doctorKey, minute, false);
+                }
+            }
+            for (uint32_t k = 0; k < sr.waitingCount; k++) {
+                const SnapshotWaiting& wr = waitingRecords[nextWaiting++];
+                if (slot->addToWaitingList(Patient(idOf(wr.patientID), idOf(wr.patientName),
+                                                   wr.priorityLevel)))
+                    patientIndex.add(idOf(wr.patientID), shard.doctorKey, minute, true);
+            }
+        }
+    }
 
-        triageQueue.push({p.getpriLevel(), p.getpID(), p.getnamePat(),
-                          doctorID, timeSlot, triageOrderCounter++});
+    for (auto& e : loadedEntries) {
+        doctors.find(e.first)->second.triage = TriageQueue(std::move(e.second), triagePolicy);
+    }
+    triageOrderCounter = std::max(triageOrderCounter.load(), static_cast<int>(counts.triageOrderCounter));
+    journalEpoch = counts.journalEpoch;
+    return true;
+}
 
-        std::cout << p.getnamePat() << " moved from waiting list.\n";
+AssignResult HospitalSystem::scheduleBySpecialty(const Patient& p, const std::string& specialty,
+                                                const std::string& fromTime) {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_ASSIGN);
+    AssignResult r{{SCHEDULE_INVALID_TIME, "", false}, "", ""};
+    int from = parseSlot(fromTime);
+    {
+        std::shared_lock<std::shared_mutex> registry(registryMutex);
+        auto group = specialties.find(specialty);
+        r.result.status = from < 0 ? SCHEDULE_INVALID_TIME : SCHEDULE_NO_FREE_SLOT;
+
+        // Earliest slot at or after `from` where some doctor of the
+        // specialty has room; among the doctors free then, the one with the
+        // fewest bookings. The least booked usually have room, so walking
+        // the doctors in booking order finds it in a step or two; after as
+        // many steps as there are free doctors, those are compared directly
+        // instead, so the search is at most O(k log k) for k free doctors.
+        // A place taken by another desk between the search and the booking
+        // just means searching again.
+        while (from >= 0 && group != specialties.end()) {
+            Specialty& sp = group->second;
+            DoctorShard* best = nullptr;
+            int bestMinute = -1, bestBooked = 0;
+            {
+                std::lock_guard<std::mutex> guard(sp.freeLock);
+                auto it = sp.freeDoctors.lower_bound(from);
+                if (it != sp.freeDoctors.end()) {
+                    bestMinute = it->first;
+                    const std::set<DoctorShard*>& free = it->second;
+                    size_t steps = free.size();
+                    for (auto e = sp.byBooked.begin(); e != sp.byBooked.end() && steps > 0; ++e, --steps) {
+                        if (free.count(e->second)) {
+                            best = e->second;
+                            bestBooked = e->first;
+                            break;
+                        }
+                    }
+                    if (!best) {
+                        for (DoctorShard* d : free) {
+                            int booked = d->booked.load(std::memory_order_relaxed);
+                            if (!best || booked < bestBooked) {
+                                best = d;
+                                bestBooked = booked;
+                            }
+                        }
+                    }
+                }
+            }
+            // Slots that availability offers but nobody booked yet are in
+            // no index; each such doctor's next one comes from its cache,
+            // which only locks the doctor when the cache does not cover `from`.
+            for (DoctorShard* d : sp.withAvailability) {
+                int key = d->cachedNextUnbooked(from);
+                if (key < 0 || (bestMinute >= 0 && key > bestMinute)) continue;
+                int booked = d->booked.load(std::memory_order_relaxed);
+                if (bestMinute < 0 || key < bestMinute || booked < bestBooked) {
+                    best = d;
+                    bestMinute = key;
+                    bestBooked = booked;
+                }
+            }
+            if (!best) break;
+
+            ShardGuard guard(*best);
+            TimeSlotInfo* slot = best->doctor.getTimeSlot(bestMinute);
+            if (slot ? !best->freeSlots.count(bestMinute) : best->doctor.capacityFor(bestMinute) == 0)
+                continue;
+            r.doctorID = best->doctor.getdID();
+            r.timeSlot = formatSlotTime(bestMinute);
+            r.result = bookLocked(*best, p, r.timeSlot, bestMinute, nullptr);
+            emitScheduled(r.result, p, r.doctorID, r.timeSlot);
+            break;
+        }
+        if (r.doctorID.empty())
+            emitScheduled(r.result, p, "", fromTime);
     }
-    rewriteAppointmentsFile();
+    compactIfNeeded();
+    return r;
 }
 
-void HospitalSystem::loadDoctorsFromFile() {
-    std::ifstream in("doctors.txt");
-    if (!in) return;
+std::string HospitalSystem::nextAvailableSlot(const std::string& doctorID, const std::string& fromTime) const {
+    std::shared_lock<std::shared_mutex> registry(registryMutex);
+    auto it = doctors.find(doctorID);
+    int from = parseSlot(fromTime);
+    if (it == doctors.end() || from < 0)
+        return "";
+    std::lock_guard<std::mutex> guard(it->second.lock);
+    int key = it->second.nextFree(from);
+    return key < 0 ? "" : formatSlotTime(key);
+}
+
+AssignResult HospitalSystem::scheduleNearest(const Patient& p, const std::string& doctorID,
+                                             const std::string& fromTime) {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_NEAREST);
+    AssignResult r{{SCHEDULE_DOCTOR_NOT_FOUND, "", false}, doctorID, ""};
+    {
+        std::shared_lock<std::shared_mutex> registry(registryMutex);
+        auto it = doctors.find(doctorID);
+        int from = parseSlot(fromTime);
+        if (it == doctors.end() || from < 0) {
+            if (it != doctors.end()) r.result.status = SCHEDULE_INVALID_TIME;
+            emitScheduled(r.result, p, doctorID, fromTime);
+            return r;
+        }
 
-    std::string id, name, spec;
-    while (in >> id >> name >> spec) {
-        doctors.emplace(id, Doctor(id, name, spec));
+        // Found and booked under one hold of the doctor's lock, so the
+        // place cannot be taken in between.
+        DoctorShard& shard = it->second;
+        ShardGuard guard(shard);
+        int key = shard.nextFree(from);
+        if (key < 0) {
+            r.result.status = SCHEDULE_NO_FREE_SLOT;
+            emitScheduled(r.result, p, doctorID, formatSlotTime(from));
+            return r;
+        }
+        r.timeSlot = formatSlotTime(key);
+        r.result = bookLocked(shard, p, r.timeSlot, key, nullptr);
+        emitScheduled(r.result, p, doctorID, r.timeSlot);
     }
+    compactIfNeeded();
+    return r;
 }
 
-void HospitalSystem::loadAppointmentsFromFile() {
-    std::ifstream in("appointments.txt");
-    if (!in) return;
-
-    std::string doctorID, timeSlot, patientID, patientName;
-    int priorityLevel;
-    while (in >> doctorID >> timeSlot >> patientID >> patientName >> priorityLevel) {
+CancelStatus HospitalSystem::cancelAppointment(const std::string& doctorID,
+                                              const std::string& timeSlot,
+                                              const std::string& patientID) {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_CANCEL);
+    {
+        std::shared_lock<std::shared_mutex> registry(registryMutex);
         auto it = doctors.find(doctorID);
-        if (it == doctors.end()) continue;
+        if (it == doctors.end()) {
+            emitCancelled(CANCEL_DOCTOR_NOT_FOUND, doctorID, timeSlot, patientID);
+            return CANCEL_DOCTOR_NOT_FOUND;
+        }
 
-        TimeSlotInfo* slot = it->second.getTimeSlot(timeSlot);
-        if (!slot) {
-            it->second.addTimeSlot(timeSlot, 2);
-            slot = it->second.getTimeSlot(timeSlot);
+        DoctorShard& shard = it->second;
+        ShardGuard guard(shard);
+
+        int minute = parseSlot(timeSlot);
+        TimeSlotInfo* slot = minute < 0 ? nullptr : shard.doctor.getTimeSlot(minute);
+        if (!slot){
+            emitCancelled(CANCEL_SLOT_NOT_FOUND, doctorID, timeSlot, patientID);
+            return CANCEL_SLOT_NOT_FOUND;
+        }
+        std::string slotText = formatSlotTime(minute);
+
+        // A patient ID never seen before cannot hold a place anywhere.
+        NameId patient;
+        bool known = names().find(patientID, patient);
+        bool waiting = known && slot->removeFromWaitingList(patient);
+        if (!waiting && !(known && slot->removeAppointmentByPatientID(patient))) {
+            emitCancelled(CANCEL_NOT_FOUND, doctorID, slotText, patientID);
+            return CANCEL_NOT_FOUND;
         }
 
-        Appointment a(doctorID, patientID, patientName, timeSlot, priorityLevel);
-        slot->addAppointment(a);
-        
-        // KRITIK FIX: Triage queue'yu doldur
-        triageQueue.push({
-            priorityLevel,
-            patientID,
-            patientName,
-            doctorID,
-            timeSlot,
-            triageOrderCounter++
-        });
+        patientIndex.remove(patient, shard.doctorKey, minute, waiting);
+        if (waiting) {
+            shard.adjust(0, 0, -1);
+        } else {
+            shard.adjust(-1, 0, 0);
+            HOSPITAL_METRIC_TRIAGE_COMPACTED(metrics, shard.appointmentDropped());
+        }
+        journal.append(JOURNAL_CANCEL, doctorID, slotText, patientID);
+        emitCancelled(CANCEL_DONE, doctorID, slotText, patientID);
+
+        // Leaving the waiting list frees no place; a freed place goes to the
+        // most urgent waiting patient.
+        if (!waiting && !slot->getWaitingList().empty()) {
+            Patient p = slot->popFromWaitingList();
+            int order = triageOrderCounter++;
+            slot->addAppointment(Appointment(p.getpIDKey(), p.getnamePatKey(), p.getpriLevel(), order));
+
+            shard.triage.push({p.getpriLevel(), p.getpIDKey(), p.getnamePatKey(),
+                               shard.doctorKey, minute, order});
+            patientIndex.promote(p.getpIDKey(), shard.doctorKey, minute);
+            shard.adjust(1, 0, -1);
+
+            journal.append(JOURNAL_PROMOTE, doctorID, slotText,
+                           p.getpID(), p.getnamePat(), p.getpriLevel());
+            emit({EVENT_PROMOTED, 0, doctorID, slotText, p.getpID(), p.getnamePat(),
+                  p.getpriLevel(), {}, false});
+        }
+        shard.slotChanged(*slot);
+        shard.releaseIfIdle(*slot);
+    }
+    compactIfNeeded();
+    return CANCEL_DONE;
+}
+
+void HospitalSystem::emitCancelled(CancelStatus status, const std::string& doctorID,
+                                   const std::string& timeSlot, const std::string& patientID) const {
+    emit({EVENT_CANCELLED, status, doctorID, timeSlot, patientID, {}, 0, {}, false});
+}
+
+void HospitalSystem::loadDoctorsFromFile() {
+    MappedFile file("doctors.txt");
+    if (!file.isOpen()) return;
+
+    std::string_view rest = file.view();
+    std::string_view id, name, spec;
+    while (nextToken(rest, id) && nextToken(rest, name) && nextToken(rest, spec)) {
+        std::string key(id);
+        addDoctorShard(Doctor(key, std::string(name), std::string(spec)));
     }
 }
 
-void HospitalSystem::callNextPatient(const std::string& doctorID) {
+void HospitalSystem::loadAvailabilityFromFile() {
+    MappedFile file("availability.txt");
+    if (!file.isOpen()) return;
+
+    std::string_view rest = file.view();
+    std::string_view id, weekdays, from, to;
+    int step, capacity;
+    while (nextToken(rest, id) && nextToken(rest, weekdays) && nextToken(rest, from) &&
+           nextToken(rest, to) && nextInt(rest, step) && nextInt(rest, capacity)) {
+        auto it = doctors.find(std::string(id));
+        AvailabilityRule rule;
+        if (it != doctors.end() && parseAvailabilityRule(weekdays, from, to, step, capacity, rule))
+            addAvailabilityLocked(it->second, rule);
+    }
+}
 
-    auto docIt = doctors.find(doctorID);
-    if (docIt == doctors.end()) {
-        std::cout << "Doctor not found.\n";
-        return;
+void HospitalSystem::loadAppointmentsFromFile() {
+    // Prefer the binary snapshot (it keeps capacities and waiting lists);
+    // appointments.txt is the fallback. The journal is replayed on top unless
+    // the snapshot already contains its epoch.
+    //
+    // Days before today are streamed to appointments.archive as they are
+    // read, never loaded, unless the journal still touches them (a run that
+    // crossed midnight without starting the new day): those are loaded,
+    // brought up to date and then archived like startDay would.
+    DayArchive archive("appointments.archive");
+    int keepFrom = std::min(today.load(), oldestJournalDay());
+    int snapshotEpoch = -1;
+    if (!loadSnapshotFile(snapshotEpoch, keepFrom, archive))
+        loadAppointmentsText(keepFrom, archive);
+
+    if (journal.readEpoch() > snapshotEpoch) {
+        journal.replay([this](const JournalRecord& r) { applyJournalRecord(r); });
+        compactIfNeeded();
+    } else {
+        // Compaction was interrupted after the snapshot was written (or the
+        // journal is missing); start the next epoch's journal.
+        journal.reset(snapshotEpoch + 1);
     }
+    // Loading fills slots directly; count once here, incrementally after.
+    recountSchedules();
 
-    if (triageQueue.empty()) {
-        std::cout << "No patients waiting.\n";
-        return;
+    archivePastDays(archive);
+    archive.close();
+    if (archive.slotsArchived() > 0)
+        compactLocked(); // keep archived days out of the snapshot from now on
+}
+
+int HospitalSystem::oldestJournalDay() {
+    int oldest = today;
+    journal.replay([&](const JournalRecord& r) {
+        int key = parseSlotTime(r.timeSlot, today);
+        if (key >= 0) oldest = std::min(oldest, slotDay(key));
+    });
+    return oldest;
+}
+
+void HospitalSystem::archivePastDays(DayArchive& archive) {
+    int day = today;
+    for (auto& dPair : doctors) {
+        DoctorShard& shard = dPair.second;
+        ShardGuard guard(shard);
+        size_t dropped = shard.doctor.archiveDaysBefore(day, [&](const TimeSlotInfo& slot) {
+            const std::string timeSlot = slot.getTimeSlot();
+            for (const auto& a : slot.getAppointments()) {
+                archive.append(dPair.first, timeSlot, a.getPatientID(), a.getPatientName(),
+                               a.getPriorityLevel());
+                patientIndex.remove(a.getPatientKey(), shard.doctorKey, slot.getMinute(), false);
+            }
+            for (const Patient& p : slot.getWaitingList())
+                patientIndex.remove(p.getpIDKey(), shard.doctorKey, slot.getMinute(), true);
+            shard.slotDropped(slot);
+            archive.slotArchived();
+        });
+        // Every triage entry of those days is stale now; drop them in one pass.
+        if (dropped > 0)
+            HOSPITAL_METRIC_TRIAGE_COMPACTED(metrics, shard.triage.compact(
+                [&shard](const TriageEntry& e) { return shard.isCurrent(e); }));
+
+    }
+}
+
+void HospitalSystem::startDay(int day) {
+    {
+        std::unique_lock<std::shared_mutex> registry(registryMutex);
+        if (day <= today) return;
+        today = day;
+        DayArchive archive("appointments.archive");
+        archivePastDays(archive);
+        archive.close();
+        if (archive.slotsArchived() > 0)
+            compactLocked();
     }
+    // Names only the archived days used are released here, or at the next
+    // day if they were looked up since the last one (InternTable::collect).
+    names().collect();
+}
 
-    std::priority_queue<TriageEntry,
-        std::vector<TriageEntry>,
-        TriageComparator> temp;
+void HospitalSystem::loadAppointmentsText(int keepFrom, DayArchive& archive) {
+    MappedFile file("appointments.txt");
+    std::string_view rest = file.view();
 
-    while (!triageQueue.empty()) {
-        TriageEntry current = triageQueue.top();
-        triageQueue.pop();
+    std::string_view doctorID, timeSlot, patientID, patientName;
+    int priorityLevel;
 
-        // Başka doktor → sakla
-        if (current.doctorID != doctorID) {
-            temp.push(current);
+    // appointments.txt is written doctor by doctor and slot by slot, so the
+    // previous record's doctor and slot are reused instead of looked up again.
+    std::string currentDoctorID, currentTimeSlot;
+    int currentMinute = -1;
+    bool archived = false; // current slot's day is before keepFrom
+    Doctor* doctor = nullptr;
+    TimeSlotInfo* slot = nullptr;
+    NameId currentDoctorKey = 0;
+    std::vector<TriageEntry>* entries = nullptr;
+    std::map<std::string, std::vector<TriageEntry>> loadedEntries;
+    bool first = true;
+
+    while (nextToken(rest, doctorID) && nextToken(rest, timeSlot) &&
+           nextToken(rest, patientID) && nextToken(rest, patientName) &&
+           nextInt(rest, priorityLevel)) {
+        if (first || doctorID != currentDoctorID) {
+            first = false;
+            currentDoctorID.assign(doctorID);
+            currentTimeSlot.clear();
+            slot = nullptr;
+            auto it = doctors.find(currentDoctorID);
+            doctor = it == doctors.end() ? nullptr : &it->second.doctor;
+            currentDoctorKey = doctor ? it->second.doctorKey : 0;
+            entries = doctor ? &loadedEntries[currentDoctorID] : nullptr;
+        }
+        if (!doctor) continue;
+
+        if (currentTimeSlot.empty() || timeSlot != currentTimeSlot) {
+            currentTimeSlot.assign(timeSlot);
+            currentMinute = parseSlotTime(timeSlot, today);
+            archived = currentMinute >= 0 && slotDay(currentMinute) < keepFrom;
+            slot = currentMinute < 0 || archived
+                       ? nullptr : doctor->addTimeSlot(currentMinute, loadedCapacity(*doctor, currentMinute));
+            if (archived) archive.slotArchived();
+        }
+        if (archived) {
+            archive.append(doctorID, timeSlot, patientID, patientName, priorityLevel);
             continue;
         }
+        if (!slot) continue;
 
-        // Timeslot var mı?
-        auto slotIt = docIt->second.getSchedule().find(current.timeSlot);
-        if (slotIt == docIt->second.getSchedule().end())
+        NameId pid = names().intern(patientID), name = names().intern(patientName);
+        if (!slot->addAppointment(Appointment(pid, name, priorityLevel, triageOrderCounter)))
             continue;
+        patientIndex.add(pid, currentDoctorKey, currentMinute, false);
 
-        // Hasta hala randevulu mu?
-        bool patientFound = false;
-        for (const auto& appt : slotIt->second.getAppointments()) {
-            if (appt.getPatientID() == current.patientID) {
-                patientFound = true;
-                break;
-            }
-        }
+        // KRITIK FIX: Triage queue'yu doldur
+        entries->push_back({
+            priorityLevel,
+            pid,
+            name,
+            currentDoctorKey,
+            currentMinute,
+            triageOrderCounter++
+        });
+    }
 
-        if (!patientFound)
-            continue;
+    // One O(k) heapify per doctor instead of k individual pushes.
+    for (auto& e : loadedEntries) {
+        doctors.find(e.first)->second.triage = TriageQueue(std::move(e.second), triagePolicy);
+    }
+}
 
-        // ✅ DOĞRU HASTA
-        std::cout << "\n=== NEXT PATIENT ===\n";
-        std::cout << "Patient ID : " << current.patientID << "\n";
-        std::cout << "Name       : " << current.patientName << "\n";
-        std::cout << "Priority   : " << current.priorityLevel << "\n";
-        std::cout << "Doctor     : " << current.doctorID << "\n";
-        std::cout << "Time Slot  : " << current.timeSlot << "\n";
+int HospitalSystem::loadedCapacity(const Doctor& d, int key) {
+    int capacity = d.capacityFor(key);
+    return capacity > 0 ? capacity : 2;
+}
 
-        docIt->second
-            .getTimeSlot(current.timeSlot)
-            ->removeAppointmentByPatientID(current.patientID);
+void HospitalSystem::applyJournalRecord(const JournalRecord& r) {
+    auto it = doctors.find(r.doctorID);
+    if (it == doctors.end()) return;
 
-        std::cout << "\nPatient has been called.\n";
+    // Replay may still touch days before today; they are archived afterwards.
+    int minute = parseSlotTime(r.timeSlot, today);
+    if (minute < 0) return;
 
-        rewriteAppointmentsFile();
+    TimeSlotInfo* slot = it->second.doctor.getTimeSlot(minute);
+    if (!slot) {
+        if (r.op == JOURNAL_CANCEL || r.op == JOURNAL_CALL) return;
+        slot = it->second.doctor.addTimeSlot(minute, loadedCapacity(it->second.doctor, minute));
+    }
 
-        // Geri kalanları geri koy
-        while (!triageQueue.empty()) {
-            temp.push(triageQueue.top());
-            triageQueue.pop();
+    NameId doctor = it->second.doctorKey;
+    NameId patient = names().intern(r.patientID);
+    NameId name = names().intern(r.patientName);
+    switch (r.op) {
+    case JOURNAL_PROMOTE:
+        if (slot->removeFromWaitingList(patient))
+            patientIndex.remove(patient, doctor, minute, true);
+        // fall through
+    case JOURNAL_SCHEDULE:
+        // Records older than the snapshot may be replayed again if a crash hit
+        // between compaction and journal reset; skip what is already there.
+        if (slot->hasAppointment(patient)) break;
+        if (slot->addAppointment(Appointment(patient, name, r.priorityLevel, triageOrderCounter))) {
+            it->second.triage.push({r.priorityLevel, patient, name,
+                                    doctor, minute, triageOrderCounter++});
+            patientIndex.add(patient, doctor, minute, false);
+        }
+        break;
+    case JOURNAL_WAITLIST:
+        if (slot->addToWaitingList(Patient(patient, name, r.priorityLevel)))
+            patientIndex.add(patient, doctor, minute, true);
+        break;
+    case JOURNAL_CANCEL:
+        // Either an appointment or a waiting-list place.
+        if (slot->removeFromWaitingList(patient)) {
+            patientIndex.remove(patient, doctor, minute, true);
+            break;
         }
-        triageQueue = temp;
+        // fall through
+    case JOURNAL_CALL:
+        // Replay leaves the heap entry behind even for a call.
+        if (slot->eraseAppointment(patient)) {
+            patientIndex.remove(patient, doctor, minute, false);
+            it->second.appointmentDropped();
+        }
+        break;
+    }
+    if (r.op == JOURNAL_CANCEL || r.op == JOURNAL_CALL)
+        it->second.releaseIfIdle(*slot); // totals are recounted after loading
+}
 
-        return;
+CallResult HospitalSystem::callNextPatient(const std::string& doctorID) {
+    HOSPITAL_METRIC_TIMER(metrics, METRIC_CALL);
+    CallResult r{CALL_DOCTOR_NOT_FOUND, TriageEntry()};
+    {
+        std::shared_lock<std::shared_mutex> registry(registryMutex);
+        auto docIt = doctors.find(doctorID);
+        if (docIt == doctors.end()) {
+            emit({EVENT_CALLED, r.status, doctorID, {}, {}, {}, 0, {}, false});
+            return r;
+        }
+
+        DoctorShard& shard = docIt->second;
+        ShardGuard guard(shard);
+
+        // Only this doctor's heap is touched; tombstones (entries whose
+        // appointment was cancelled) are discarded as they surface, and
+        // compaction keeps them from piling up. The heap puts earlier days
+        // first, so a later-day entry is never called today.
+        r.status = CALL_QUEUE_EMPTY;
+        int stale = 0;
+        TriageEntry current{};
+        if (shard.triage.popNext(triageNow(), today, [&shard](const TriageEntry& e) { return shard.isCurrent(e); },
+                                 current, stale)) {
+            // ✅ DOĞRU HASTA
+            TimeSlotInfo* slot = shard.doctor.getTimeSlot(current.slotMinute);
+            slot->removeAppointmentByPatientID(current.patientID);
+            patientIndex.remove(current.patientID, shard.doctorKey, current.slotMinute, false);
+            shard.adjust(-1, 0, 0);
+            shard.slotChanged(*slot);
+            shard.releaseIfIdle(*slot);
+
+            journal.append(JOURNAL_CALL, doctorID, formatSlotTime(current.slotMinute),
+                           names().str(current.patientID));
+            r.status = CALL_DONE;
+            r.patient = current;
+        } else if (stale > 0) {
+            r.status = CALL_NO_VALID_PATIENT;
+        }
+        HOSPITAL_METRIC_STALE_POPS(metrics, stale);
+
+        const TriageEntry& e = r.patient;
+        std::string slotText = r.status == CALL_DONE ? formatSlotTime(e.slotMinute) : "";
+        emit({EVENT_CALLED, r.status, doctorID, slotText, names().str(e.patientID),
+              names().str(e.patientName), e.priorityLevel, {}, false});
+        // Uygun hasta bulunamadıysa
+        if (r.status != CALL_DONE)
+            return r;
     }
+    compactIfNeeded();
+    return r;
+}
 
-    // Uygun hasta bulunamadıysa
-    triageQueue = temp;
-    std::cout << "No valid patients for this doctor.\n";
+int HospitalSystem::triageNow() const {
+    int day = today;
+    return std::min(std::max(currentSlotKey(), day * MINUTES_PER_DAY), day * MINUTES_PER_DAY + MINUTES_PER_DAY - 1);
 }
 
+void HospitalSystem::setTriagePolicy(const TriagePolicy& policy) {
+    std::unique_lock<std::shared_mutex> registry(registryMutex);
+    triagePolicy = policy;
+    for (auto& dPair : doctors) {
+        std::lock_guard<std::mutex> guard(dPair.second.lock);
+        dPair.second.triage.setPolicy(policy);
+    }
+}
+
+TriagePolicy HospitalSystem::getTriagePolicy() const {
+    std::shared_lock<std::shared_mutex> registry(registryMutex);
+    return triagePolicy;
+}
 
 void HospitalSystem::listAppointmentsFor(const std::string& doctorID,
                                         const std::string& timeSlot) const {
-
-    auto docIt = doctors.find(doctorID);
-    if (docIt == doctors.end()) {
+    std::shared_ptr<const DoctorView> d = getDoctorView(doctorID);
+    if (!d) {
         std::cout << "Doctor not found.\n";
         return;
     }
 
-    auto slotIt = docIt->second.getSchedule().find(timeSlot);
-    if (slotIt == docIt->second.getSchedule().end()) {
+    int minute = parseSlot(timeSlot);
+    const DayView* day = minute < 0 ? nullptr : d->findDay(slotDay(minute));
+    const SlotView* found = day ? day->find(minute) : nullptr;
+    if (!found) {
         std::cout << "Time slot not found.\n";
         return;
     }
 
-    const TimeSlotInfo& slot = slotIt->second;
+    const SlotView& slot = *found;
 
     std::cout << "\n=== APPOINTMENTS ===\n";
     std::cout << "Doctor   : " << doctorID << "\n";
-    std::cout << "TimeSlot : " << timeSlot << "\n";
-    std::cout << "Capacity : " << slot.getCapacity() << "\n";
-    std::cout << "Booked   : " << slot.getAppointmentCount() << "\n\n";
+    std::cout << "TimeSlot : " << formatSlotTime(minute) << "\n";
+    std::cout << "Capacity : " << slot.capacity << "\n";
+    std::cout << "Booked   : " << slot.booked << "\n\n";
 
-    if (slot.getAppointments().empty()) {
+    if (slot.booked == 0) {
         std::cout << "No appointments.\n";
     } else {
-        for (const auto& a : slot.getAppointments()) {
-            std::cout << "- " << a.getPatientID()
-                      << " | " << a.getPatientName()
-                      << " | priority " << a.getPriorityLevel()
+        for (const BookingView* a = day->bookings(slot); a != day->bookings(slot) + slot.booked; ++a) {
+            std::cout << "- " << names().str(a->patientID)
+                      << " | " << names().str(a->patientName)
+                      << " | priority " << a->priorityLevel
                       << "\n";
         }
     }
 
     std::cout << "\n--- Waiting List ---\n";
-    if (slot.getWaitingList().empty()) {
+    if (slot.waiting == 0) {
         std::cout << "No patients waiting.\n";
     } else {
-        std::queue<Patient> temp = slot.getWaitingList();
-        while (!temp.empty()) {
-            Patient p = temp.front();
-            temp.pop();
-            std::cout << "- " << p.getpID()
-                      << " | " << p.getnamePat()
-                      << " | priority " << p.getpriLevel()
+        for (const BookingView* p = day->waitingList(slot); p != day->waitingList(slot) + slot.waiting; ++p) {
+            std::cout << "- " << names().str(p->patientID)
+                      << " | " << names().str(p->patientName)
+                      << " | priority " << p->priorityLevel
                       << "\n";
         }
     }
 }
 
+std::vector<PatientLocation> HospitalSystem::getPatientLocations(const std::string& patientID) const {
+    NameId patient;
+    if (!names().find(patientID, patient)) return std::vector<PatientLocation>();
+    return patientIndex.find(patient);
+}
+
+void HospitalSystem::findPatient(const std::string& patientID) const {
+    std::vector<PatientLocation> sorted = getPatientLocations(patientID);
+    if (sorted.empty()) {
+        std::cout << "Patient has no appointments or waiting list places.\n";
+        return;
+    }
+
+    std::sort(sorted.begin(), sorted.end(),
+              [](const PatientLocation& a, const PatientLocation& b) {
+                  return a.slotMinute < b.slotMinute;
+              });
+
+    std::cout << "\n=== PATIENT " << patientID << " ===\n";
+    for (const PatientLocation& l : sorted) {
+        std::cout << "- " << formatSlotTime(l.slotMinute)
+                  << " | doctor " << names().str(l.doctorID)
+                  << " | " << (l.waitlisted ? "waiting list" : "appointment")
+                  << "\n";
+    }
+}
+
+bool HospitalSystem::checkInvariants(std::string& problem, bool waitlistsBehindFullSlots) const {
+    std::unique_lock<std::shared_mutex> registry(registryMutex);
+    std::ostringstream out;
+
+    // Every slot entry must be in the patient index exactly once, and the
+    // index must hold nothing else.
+    std::map<std::string, int> expected; // "patient doctor minute kind" -> count
+    for (const auto& dPair : doctors) {
+        const Doctor& d = dPair.second.doctor;
+        for (const TimeSlotInfo& slot : d.getSchedule()) {
+            if (slotDay(slot.getMinute()) < today)
+                out << d.getdID() << " " << slot.getTimeSlot() << " belongs to an archived day. ";
+            if (static_cast<int>(slot.getAppointmentCount()) > slot.getCapacity())
+                out << d.getdID() << " " << slot.getTimeSlot() << " is over capacity. ";
+            if (waitlistsBehindFullSlots && !slot.getWaitingList().empty() &&
+                static_cast<int>(slot.getAppointmentCount()) < slot.getCapacity())
+                out << d.getdID() << " " << slot.getTimeSlot() << " has free places but waiting patients. ";
+            for (const auto& a : slot.getAppointments())
+                expected[a.getPatientID() + " " + d.getdID() + " " + slot.getTimeSlot() + " A"]++;
+            for (const Patient& p : slot.getWaitingList())
+                expected[p.getpID() + " " + d.getdID() + " " + slot.getTimeSlot() + " W"]++;
+        }
+    }
+    std::map<std::string, int> indexed;
+    std::map<std::string, int> perMinute; // "patient minute" -> places
+    patientIndex.forEach([&](NameId patient, const PatientLocation& l) {
+        const std::string& patientID = names().str(patient);
+        indexed[patientID + " " + names().str(l.doctorID) + " " + formatSlotTime(l.slotMinute) +
+                (l.waitlisted ? " W" : " A")]++;
+        perMinute[patientID + " " + formatSlotTime(l.slotMinute)]++;
+    });
+    if (indexed != expected)
+        out << "Patient index does not match the schedules. ";
+    for (const auto& m : perMinute) {
+        if (m.second > 1)
+            out << "Patient " << m.first << " holds " << m.second << " places. ";
+    }
+
+    // Incremental totals must equal a recount.
+    std::map<std::string, DoctorLoad> bySpecialty;
+    for (const auto& dPair : doctors) {
+        DoctorLoad actual;
+        size_t free = 0;
+        for (const TimeSlotInfo& slot : dPair.second.doctor.getSchedule()) {
+            if (!slot.isFullAppointments()) {
+                free++;
+                if (!dPair.second.freeSlots.count(slot.getMinute()))
+                    out << dPair.first << " " << slot.getTimeSlot() << " is free but not indexed. ";
+            }
+            actual.booked += static_cast<int>(slot.getAppointmentCount());
+            actual.capacity += slot.getCapacity();
+            actual.waitlisted += static_cast<int>(slot.getWaitingList().size());
+        }
+        const DoctorLoad& kept = dPair.second.load;
+        if (kept.booked != actual.booked || kept.capacity != actual.capacity ||
+            kept.waitlisted != actual.waitlisted)
+            out << dPair.first << " totals are out of date. ";
+        if (free != dPair.second.freeSlots.size())
+            out << dPair.first << " free slot index has full or missing slots. ";
+        if (!dPair.second.specialty->byBooked.count({kept.booked, const_cast<DoctorShard*>(&dPair.second)}))
+            out << dPair.first << " is out of place in the specialty's booking order. ";
+        uint64_t offered = dPair.second.offered.load();
+        if (offered != DoctorShard::NO_OFFER) {
+            int key = dPair.second.nextUnbooked(static_cast<int>(offered >> 32), -1);
+            if ((key < 0 ? DoctorShard::NO_KEY : static_cast<uint32_t>(key)) != (offered & DoctorShard::NO_KEY))
+                out << dPair.first << " next offered time is out of date. ";
+        }
+        // One current triage entry per booking; everything else is a counted tombstone.
+        size_t current = 0;
+        dPair.second.triage.forEach([&](const TriageEntry& e) {
+            if (dPair.second.isCurrent(e)) current++;
+        });
+        if (current != static_cast<size_t>(actual.booked))
+            out << dPair.first << " triage heap does not match the bookings. ";
+        if (dPair.second.triage.size() - current != dPair.second.triage.staleCount())
+            out << dPair.first << " triage tombstone count is off. ";
+        // Reports read the published view, which must match the schedule.
+        std::shared_ptr<const DoctorView> view = currentView(dPair.second);
+        const Schedule& schedule = dPair.second.doctor.getSchedule();
+        bool published = view && view->slotCount() == schedule.size() && view->load.booked == kept.booked &&
+                         view->load.capacity == kept.capacity && view->load.waitlisted == kept.waitlisted;
+        for (auto it = schedule.begin(); published && it != schedule.end(); ++it) {
+            const DayView* day = view->findDay(slotDay(it->getMinute()));
+            const SlotView* s = day ? day->find(it->getMinute()) : nullptr;
+            published = s && s->capacity == it->getCapacity() &&
+                        s->booked == static_cast<int>(it->getAppointmentCount()) &&
+                        s->waiting == static_cast<int>(it->getWaitingList().size());
+        }
+        if (!published)
+            out << dPair.first << " published view is out of date. ";
+        DoctorLoad& sum = bySpecialty[dPair.second.doctor.getdSpecialty()];
+        sum.booked += actual.booked;
+        sum.capacity += actual.capacity;
+        sum.waitlisted += actual.waitlisted;
+    }
+    for (const auto& sPair : specialties) {
+        const DoctorLoad& sum = bySpecialty[sPair.first];
+        if (sPair.second.booked != sum.booked || sPair.second.capacity != sum.capacity ||
+            sPair.second.waitlisted != sum.waitlisted)
+            out << sPair.first << " specialty totals are out of date. ";
+    }
+
+    problem = out.str();
+    return problem.empty();
+}
+
+DoctorLoad HospitalSystem::getDoctorLoad(const std::string& doctorID) const {
+    std::shared_lock<std::shared_mutex> registry(registryMutex);
+    auto it = doctors.find(doctorID);
+    if (it == doctors.end()) return DoctorLoad();
+    std::lock_guard<std::mutex> guard(it->second.lock);
+    return it->second.load;
+}
+
+std::map<std::string, DoctorLoad> HospitalSystem::getSpecialtyLoads() const {
+    std::shared_lock<std::shared_mutex> registry(registryMutex);
+    std::map<std::string, DoctorLoad> result;
+    for (const auto& sPair : specialties) {
+        DoctorLoad& l = result[sPair.first];
+        l.booked = sPair.second.booked.load(std::memory_order_relaxed);
+        l.capacity = sPair.second.capacity.load(std::memory_order_relaxed);
+        l.waitlisted = sPair.second.waitlisted.load(std::memory_order_relaxed);
+    }
+    return result;
+}
+
+void HospitalSystem::listSpecialties() const {
+    std::map<std::string, DoctorLoad> loads = getSpecialtyLoads();
+    if (loads.empty()) {
+        std::cout << "No doctors in the system.\n";
+        return;
+    }
+    for (const auto& l : loads) {
+        std::cout << l.first << " | Booked: " << l.second.booked << "/" << l.second.capacity
+                  << " | Waiting: " << l.second.waitlisted
+                  << " | Utilization: " << static_cast<int>(l.second.utilization() * 100 + 0.5) << "%\n";
+    }
+}
+
+void HospitalSystem::writeMetrics(std::ostream& out) const {
+    metrics.write(out);
+
+    std::shared_lock<std::shared_mutex> registry(registryMutex);
+    out << "# HELP hms_journal_records Records in appointments.journal since the last compaction.\n";
+    out << "# TYPE hms_journal_records gauge\n";
+    out << "hms_journal_records " << journal.getRecordCount() << "\n";
+    out << "# HELP hms_triage_queue_depth Entries in a doctor's triage heap, stale ones included.\n";
+    out << "# TYPE hms_triage_queue_depth gauge\n";
+    for (const auto& dPair : doctors) {
+        std::lock_guard<std::mutex> guard(dPair.second.lock);
+        out << "hms_triage_queue_depth{doctor=\"" << dPair.first << "\"} "
+            << dPair.second.triage.size() << "\n";
+    }
+    out << "# HELP hms_names_interned Distinct IDs and names interned in the process.\n";
+    out << "# TYPE hms_names_interned gauge\n";
+    out << "hms_names_interned " << names().size() << "\n";
+    out << "# HELP hms_names_capacity Interned names past which new patients get NAMES_FULL.\n";
+    out << "# TYPE hms_names_capacity gauge\n";
+    out << "hms_names_capacity " << InternTable::capacity() << "\n";
+    out << "# HELP hms_waitlist_length Patients on a slot's waiting list (non-empty lists only).\n";
+    out << "# TYPE hms_waitlist_length gauge\n";
+    for (const auto& dPair : doctors) {
+        std::lock_guard<std::mutex> guard(dPair.second.lock);
+        for (const TimeSlotInfo& slot : dPair.second.doctor.getSchedule()) {
+            if (slot.getWaitingList().empty()) continue;
+            out << "hms_waitlist_length{doctor=\"" << dPair.first << "\",slot=\"" << slot.getTimeSlot()
+                << "\"} " << slot.getWaitingList().size() << "\n";
+        }
+    }
+}
+
+bool HospitalSystem::writeMetricsFile(const std::string& path) const {
+    // Renamed into place so a scraper never reads a half-written file.
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp);
+        if (!out) return false;
+        writeMetrics(out);
+        if (!out) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
 void HospitalSystem::runMenu() {
+    // The menu is the console renderer: operation outcomes come back as
+    // events and are printed by this sink while the menu runs. A sink set
+    // before (an exporter) keeps receiving them too.
+    ConsoleEventSink console(std::cout);
+    HospitalEventSink* previous = events.load();
+    TeeEventSink both(console, *previous);
+    if (previous == &nullEvents)
+        events = &console;
+    else
+        events = &both;
     int choice;
 
     while (true) {
+        // A session left open past midnight moves on to the new day.
+        int day = currentDay();
+        if (day > today)
+            startDay(day);
+
         std::cout << "\n===== Hospital System =====\n";
         std::cout << "1. Add Doctor\n";
         std::cout << "2. List Doctors\n";
@@ -333,6 +1420,13 @@ void HospitalSystem::runMenu() {
         std::cout << "5. Cancel Appointment\n";
         std::cout << "6. Call Next Patient\n";
         std::cout << "7. List Appointments for Doctor & TimeSlot\n";
+        std::cout << "8. View Doctor Schedule Between Times\n";
+        std::cout << "9. Find Patient\n";
+        std::cout << "10. Show Metrics\n";
+        std::cout << "11. Specialty Summary\n";
+        std::cout << "12. Auto-Assign by Specialty\n";
+        std::cout << "13. Add Doctor Availability\n";
+        std::cout << "14. Book Nearest Available Slot\n";
         std::cout << "0. Exit\n";
         std::cout << "Choice: ";
 
@@ -392,7 +1486,7 @@ void HospitalSystem::runMenu() {
             }
 
             if (!isValidTime(time)) {
-                std::cout << "Time format must be HH:MM\n";
+                std::cout << "Time must be HH:MM (today) or YYYY-MM-DDTHH:MM, not before today\n";
                 break;
             }
 
@@ -418,8 +1512,235 @@ void HospitalSystem::runMenu() {
             listAppointmentsFor(id, time);
             break;
         }
+        case 8: {
+            std::cout << "DoctorID From To (HH:MM or YYYY-MM-DDTHH:MM): ";
+            std::cin >> id >> time >> spec;
+            viewDoctorSchedule(id, time, spec);
+            break;
+        }
+        case 9:
+            std::cout << "PatientID: ";
+            std::cin >> id;
+            findPatient(id);
+            break;
+        case 10:
+            writeMetrics(std::cout);
+            if (writeMetricsFile("hospital.metrics"))
+                std::cout << "Metrics written to hospital.metrics.\n";
+            break;
+        case 11:
+            listSpecialties();
+            break;
+        case 12: {
+            std::cout << "PatientID Name Priority Specialty From(HH:MM or YYYY-MM-DDTHH:MM): ";
+            if (!(std::cin >> id >> name >> priority >> spec >> time)) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::cout << "Invalid input.\n";
+                break;
+            }
+            AssignResult r = scheduleBySpecialty(Patient(id, name, priority), spec, time);
+            if (r.result.status == SCHEDULE_BOOKED)
+                std::cout << "Assigned to doctor " << r.doctorID << " at " << r.timeSlot << ".\n";
+            break;
+        }
+        case 13: {
+            std::string days, until;
+            int step, capacity;
+            std::cout << "DoctorID Days(Mon-Fri) From(HH:MM) To(HH:MM) StepMinutes Capacity: ";
+            if (!(std::cin >> id >> days >> time >> until >> step >> capacity)) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::cout << "Invalid input.\n";
+                break;
+            }
+            AvailabilityRule rule;
+            parseAvailabilityRule(days, time, until, step, capacity, rule);
+            switch (addAvailability(id, rule)) {
+            case AVAILABILITY_ADDED:            std::cout << "Availability added.\n"; break;
+            case AVAILABILITY_DOCTOR_NOT_FOUND: std::cout << "Doctor not found.\n"; break;
+            case AVAILABILITY_INVALID:          std::cout << "Invalid availability.\n"; break;
+            }
+            break;
+        }
+        case 14: {
+            std::cout << "PatientID Name Priority DoctorID From(HH:MM or YYYY-MM-DDTHH:MM): ";
+            if (!(std::cin >> id >> name >> priority >> spec >> time)) {
+                std::cin.clear();
+                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
+                std::cout << "Invalid input.\n";
+                break;
+            }
+            AssignResult r = scheduleNearest(Patient(id, name, priority), spec, time);
+            if (r.result.status == SCHEDULE_BOOKED)
+                std::cout << "Booked at " << r.timeSlot << ".\n";
+            break;
+        }
         default:
             std::cout << "Invalid choice.\n";
         }
     }
+    events = previous;
+}
+
+void HospitalSystem::runCommand(const Command& c, std::string& responses) {
+    std::string id(c.id), name(c.name), target(c.target), time(c.time);
+    switch (c.op) {
+    case COMMAND_ADD_DOCTOR:
+        responses += doctorStatusName(addDoctor(Doctor(id, name, target)));
+        responses += '\n';
+        break;
+    case COMMAND_AVAILABILITY: {
+        AvailabilityRule rule;
+        parseAvailabilityRule(c.name, c.time, c.until, c.priority, c.capacity, rule);
+        responses += availabilityStatusName(addAvailability(id, rule));
+        responses += '\n';
+        break;
+    }
+    case COMMAND_SCHEDULE:
+        appendScheduleResponse(responses, scheduleAppointment(Patient(id, name, c.priority), target, time));
+        break;
+    case COMMAND_ASSIGN: {
+        AssignResult r = scheduleBySpecialty(Patient(id, name, c.priority), target, time);
+        if (r.result.status != SCHEDULE_BOOKED) {
+            appendScheduleResponse(responses, r.result);
+            break;
+        }
+        responses += "BOOKED " + r.doctorID + " " + r.timeSlot + "\n";
+        break;
+    }
+    case COMMAND_NEAREST: {
+        AssignResult r = scheduleNearest(Patient(id, name, c.priority), target, time);
+        if (r.result.status != SCHEDULE_BOOKED) {
+            appendScheduleResponse(responses, r.result);
+            break;
+        }
+        responses += "BOOKED " + r.timeSlot + "\n";
+        break;
+    }
+    case COMMAND_NEXT_FREE: {
+        std::string next = nextAvailableSlot(id, time);
+        responses += next.empty() ? "NONE\n" : "NEXT " + next + "\n";
+        break;
+    }
+    case COMMAND_CANCEL:
+        responses += cancelStatusName(cancelAppointment(id, time, target));
+        responses += '\n';
+        break;
+    case COMMAND_CALL: {
+        CallResult r = callNextPatient(id);
+        responses += callStatusName(r.status);
+        if (r.status == CALL_DONE) {
+            responses += ' ';
+            responses += names().str(r.patient.patientID);
+            responses += ' ';
+            responses += names().str(r.patient.patientName);
+            responses += ' ' + std::to_string(r.patient.priorityLevel) + ' ' +
+                         formatSlotTime(r.patient.slotMinute);
+        }
+        responses += '\n';
+        break;
+    }
+    case COMMAND_FIND: {
+        std::vector<PatientLocation> found = getPatientLocations(id);
+        std::sort(found.begin(), found.end(),
+                  [](const PatientLocation& a, const PatientLocation& b) { return a.slotMinute < b.slotMinute; });
+        responses += "FOUND " + std::to_string(found.size());
+        for (const PatientLocation& l : found) {
+            responses += ' ';
+            responses += names().str(l.doctorID);
+            responses += ' ' + formatSlotTime(l.slotMinute) + (l.waitlisted ? " WAITING" : " BOOKED");
+        }
+        responses += '\n';
+        break;
+    }
+    case COMMAND_LIST: {
+        std::shared_ptr<const DoctorDirectory> all = std::atomic_load(&directory);
+        responses += "DOCTORS " + std::to_string(all ? all->size() : 0);
+        if (all) {
+            for (const auto& entry : *all) {
+                const Doctor& d = entry.second->doctor;
+                responses += ' ' + *entry.first + ' ' + d.getdName() + ' ' + d.getdSpecialty() + ' ' +
+                             std::to_string(entry.second->booked.load(std::memory_order_relaxed));
+            }
+        }
+        responses += '\n';
+        break;
+    }
+    case COMMAND_DAY: {
+        int day = parseDate(c.time);
+        if (day < 0) {
+            responses += "ERROR malformed\n";
+            break;
+        }
+        startDay(day);
+        responses += "DAY " + formatDate(today) + "\n";
+        break;
+    }
+    }
+}
+
+bool HospitalSystem::runCommandLine(std::string_view line, std::string& responses) {
+    Command c;
+    CommandParse parsed = parseCommand(line, c);
+    if (parsed == COMMAND_SKIP)
+        return false;
+    if (parsed == COMMAND_MALFORMED)
+        responses += "ERROR malformed\n";
+    else
+        runCommand(c, responses);
+    return true;
+}
+
+size_t HospitalSystem::runCommandLines(std::string_view& input, std::string& responses, bool final) {
+    size_t executed = 0;
+    while (!input.empty()) {
+        size_t end = input.find('\n');
+        if (end == std::string_view::npos && !final)
+            break;
+        if (runCommandLine(input.substr(0, end), responses))
+            executed++;
+        input.remove_prefix(end == std::string_view::npos ? input.size() : end + 1);
+    }
+    return executed;
+}
+
+void HospitalSystem::beginCommandBatch() {
+    journal.beginGroupCommit();
+}
+
+void HospitalSystem::endCommandBatch() {
+    journal.endGroupCommit();
+    // Like the menu, a stream left running past midnight moves on.
+    int day = currentDay();
+    if (day > today)
+        startDay(day);
+}
+
+size_t HospitalSystem::runCommands(std::istream& in, std::ostream& out) {
+    const size_t maxBatch = 1024; // commands answered at most per group commit
+    std::string line, responses;
+    size_t executed = 0, held = 0;
+
+    beginCommandBatch();
+    while (std::getline(in, line)) {
+        if (runCommandLine(line, responses)) {
+            executed++;
+            held++;
+        }
+        // Nothing more buffered means the next read may wait on the writer:
+        // make the batch durable and answer it first.
+        if (held >= maxBatch || in.rdbuf()->in_avail() <= 0) {
+            endCommandBatch();
+            out.write(responses.data(), responses.size());
+            out.flush();
+            responses.clear();
+            held = 0;
+            beginCommandBatch();
+        }
+    }
+    journal.endGroupCommit();
+    out.write(responses.data(), responses.size());
+    out.flush();
+    return executed;
 }
@@ -9,34 +9,200 @@
 #include "Patient.h"
 #include "Doctor.h"
 #include "Timeslotinfo.h"
+#include "SlotTime.h"
 #include "Appointment.h"
 #include "TriageEntry.h"
+#include "AppointmentJournal.h"
+#include "MappedFile.h"
+#include "HospitalSnapshot.h"
+#include "PatientIndex.h"
+#include "DoctorShard.h"
+#include "ScheduleView.h"
+#include "HospitalStatus.h"
+#include "HospitalEvents.h"
+#include "HospitalMetrics.h"
+#include "DayArchive.h"
+#include "CommandStream.h"
+#include <atomic>
 #include <limits>
+#include <shared_mutex>
 #include <vector>
 
 
+// Thread safety: every public operation may be called concurrently.
+// registryMutex guards the shape of `doctors` (shared for bookings, calls and
+// lookups; exclusive for addDoctor, addAvailability, startDay, compaction and
+// the triage policy); each DoctorShard has its own lock for its schedule,
+// availability and triage queue, so operations on different doctors never
+// contend. Reports take no lock at all: they read the view that writers
+// publish as they release a doctor (ScheduleView.h), so whatever changes a
+// doctor's slots or rules holds its lock through a ShardGuard, under an
+// exclusive registry too. Lock order: registry -> one doctor -> patient
+// index shard.
 class HospitalSystem{
     private:
-        std::map<std::string, Doctor> doctors;
-        std::priority_queue<TriageEntry, std::vector<TriageEntry>, TriageComparator> triageQueue;
-        int triageOrderCounter;
+        std::map<std::string, DoctorShard> doctors; // keyed by doctorID
+        std::map<std::string, Specialty> specialties; // shape guarded like doctors
+        // Published copy of the doctor list for lock-free reports; use only
+        // with std::atomic_load / std::atomic_store.
+        std::shared_ptr<const DoctorDirectory> directory;
+        mutable std::shared_mutex registryMutex;
+        PatientIndex patientIndex; // patientID -> appointment and waiting-list places
+        std::atomic<int> today;    // day number of "HH:MM" slots; earlier days are archived
+        std::atomic<int> triageOrderCounter;
+        TriagePolicy triagePolicy; // call-queue order, guarded like doctors
+        AppointmentJournal journal; // appointments.journal, replayed over appointments.txt
+        NullEventSink nullEvents;
+        std::atomic<HospitalEventSink*> events; // never null; nullEvents when unset
+        mutable HospitalMetrics metrics;
+        size_t namesRoot; // this system's records in names(), see markNames
 
+        // Marks every NameId the records hold, for InternTable::collect.
+        void markNames(const InternTable::Mark& mark) const;
         void loadDoctorsFromFile();
+        void loadAvailabilityFromFile();
         void loadAppointmentsFromFile();
+        // Both loaders stream slots of days before keepFrom straight into
+        // the archive instead of loading them.
+        void loadAppointmentsText(int keepFrom, DayArchive& archive);
+        bool loadSnapshotFile(int& journalEpoch, int keepFrom, DayArchive& archive);
+        int oldestJournalDay();
+        void applyJournalRecord(const JournalRecord& r);
+        // Capacity for a slot recreated from the files: what the doctor's
+        // availability gives it, or the default 2 if that no longer offers it.
+        static int loadedCapacity(const Doctor& d, int key);
+        // Moves every slot before today out of memory and into the archive;
+        // registry held exclusively (or still constructing).
+        void archivePastDays(DayArchive& archive);
+        // Slot key of a menu/API time, or -1 if invalid or before today.
+        int parseSlot(const std::string& timeSlot) const;
+        // The clock for triage deadlines and aging: now, held within today.
+        int triageNow() const;
         void rewriteAppointmentsFile() const;
+        void writeSnapshotFile(int journalEpoch) const;
+        // Books or waitlists one patient with the doctor's lock held; journals
+        // into batch when given, otherwise straight to the journal.
+        ScheduleResult bookLocked(DoctorShard& shard, const Patient& p, const std::string& timeSlot,
+                                  int minute, JournalBatch* batch);
+        // Sends e to the sink, stamped with today.
+        void emit(HospitalEvent e) const;
+        void emitScheduled(const ScheduleResult& r, const Patient& p, const std::string& doctorID,
+                           const std::string& timeSlot) const;
+        void emitCancelled(CancelStatus status, const std::string& doctorID, const std::string& timeSlot,
+                           const std::string& patientID) const;
+        void compactIfNeeded();
+        void compactLocked();
+        DoctorShard& addDoctorShard(const Doctor& d);
+        // Republishes the doctor list; registry held exclusively.
+        void publishDirectory();
+        void recountSchedules();
         void appendDoctorToFile(const Doctor& d) const;
+        void appendAvailabilityToFile(const std::string& doctorID, const AvailabilityRule& rule) const;
+        void addAvailabilityLocked(DoctorShard& shard, const AvailabilityRule& rule);
+        // Executes one parsed command and appends its response line.
+        void runCommand(const Command& c, std::string& responses);
+        // Parses and executes one line; false for a blank line or comment,
+        // which gets no response.
+        bool runCommandLine(std::string_view line, std::string& responses);
 
     public:
-        HospitalSystem();
+        // `day` is today's day number (see SlotTime.h); bookings for days
+        // before it found on disk are archived while loading.
+        explicit HospitalSystem(int day = currentDay());
+        ~HospitalSystem();
         
         bool isValidTime(const std::string& time) const;
-        void addDoctor(const Doctor& d);
+        // Outcomes go to the event sink (silent by default; runMenu installs
+        // a ConsoleEventSink) and are also returned. Set the sink before
+        // other threads start calling in, and keep it alive while in use.
+        void setEventSink(HospitalEventSink* sink);
+        DoctorStatus addDoctor(const Doctor& d);
+        // Adds a recurring block of slots to the doctor's week (saved in
+        // availability.txt). Its slots are only created once booked, and
+        // times outside a doctor's availability can no longer be booked.
+        AvailabilityStatus addAvailability(const std::string& doctorID, const AvailabilityRule& rule);
+        // The reports below (listDoctors, viewDoctorSchedule,
+        // listAppointmentsFor) take no registry or doctor locks: they read
+        // the published doctor list and schedule views, so they never wait
+        // for scheduling.
         void listDoctors() const;
+        // Booked/capacity/waitlisted totals, maintained on every change, so
+        // these cost O(1) per doctor or specialty whatever the schedule size.
+        DoctorLoad getDoctorLoad(const std::string& doctorID) const;
+        std::map<std::string, DoctorLoad> getSpecialtyLoads() const;
+        void listSpecialties() const;
         void viewDoctorSchedule(const std::string& doctorID) const;
-        void scheduleAppointment(const Patient& p, const std::string& doctorID, const std::string& timeSlot);
-        void cancelAppointment(const std::string& doctorID, const std::string& timeSlot, const std::string& patientID);
-        void callNextPatient(const std::string& doctorID);
+        void viewDoctorSchedule(const std::string& doctorID, const std::string& from, const std::string& to) const;
+        ScheduleResult scheduleAppointment(const Patient& p, const std::string& doctorID, const std::string& timeSlot);
+        // Bulk import: validates everything, applies it doctor by doctor and
+        // journals it with a single write and fsync. Results line up with the
+        // requests.
+        std::vector<ScheduleResult> scheduleAppointments(const std::vector<ScheduleRequest>& batch);
+        // Books the earliest slot with a free place at or after fromTime with
+        // any doctor of the specialty, preferring the doctor with the fewest
+        // bookings when several are free at that time. Existing slots with room count,
+        // and so do slots a doctor's availability offers that nobody has
+        // booked yet.
+        AssignResult scheduleBySpecialty(const Patient& p, const std::string& specialty,
+                                         const std::string& fromTime);
+        // Earliest time at or after fromTime where the doctor has a free
+        // place (see DoctorShard::nextFree), in full form; empty if there is
+        // none, the doctor is unknown or the time invalid.
+        std::string nextAvailableSlot(const std::string& doctorID, const std::string& fromTime) const;
+        // Opt-in "book nearest" mode: like scheduleAppointment, but when
+        // fromTime has no free place the patient is booked into the doctor's
+        // next time that has one instead of being waitlisted
+        // (SCHEDULE_NO_FREE_SLOT if there is none). The result names the
+        // time booked.
+        AssignResult scheduleNearest(const Patient& p, const std::string& doctorID, const std::string& fromTime);
+        CancelStatus cancelAppointment(const std::string& doctorID, const std::string& timeSlot, const std::string& patientID);
+        // Calls the top of the doctor's queue under the triage policy (see
+        // TriagePolicy): overdue patients first, then by priority, aged by
+        // how long they have waited past their slot time when aging is on.
+        CallResult callNextPatient(const std::string& doctorID);
+        // Applies to every doctor's queue, now and added later; the default
+        // policy is the static priority rule. Waiting lists keep that rule.
+        void setTriagePolicy(const TriagePolicy& policy);
+        TriagePolicy getTriagePolicy() const;
         void listAppointmentsFor(const std::string& doctorID, const std::string& timeSlot) const;
+        void findPatient(const std::string& patientID) const;
+        std::vector<PatientLocation> getPatientLocations(const std::string& patientID) const;
+        // The doctor's latest published schedule (null for an unknown
+        // doctor): an immutable, versioned copy that stays consistent however
+        // long it is kept, while bookings go on.
+        std::shared_ptr<const DoctorView> getDoctorView(const std::string& doctorID) const;
+        void saveSnapshot(); // compact the journal into hospital.snapshot now
+        // Moves on to a later day: what is left of earlier days goes to
+        // appointments.archive and out of memory, and the files are compacted.
+        // Interned names no record uses any more are released.
+        void startDay(int day);
+        int getToday() const { return today; };
+        // Cross-checks slots, waiting lists and the patient index. With
+        // waitlistsBehindFullSlots, a waiting patient next to a free place is
+        // also an error (only true if callNextPatient has not freed places).
+        bool checkInvariants(std::string& problem, bool waitlistsBehindFullSlots = false) const;
+        // Operation counters and latencies plus triage heap and waiting
+        // list gauges, in Prometheus text format.
+        void writeMetrics(std::ostream& out) const;
+        bool writeMetricsFile(const std::string& path) const;
         void runMenu();
+        // Headless mode: executes the command stream on `in` (see
+        // CommandStream.h) and writes one response line per command to
+        // `out`. Commands run in input order, exactly as the menu would run
+        // them, but are journaled as one group commit per batch: responses
+        // are written once the batch is fsync'ed, whenever the input has
+        // nothing more buffered or 1024 commands are waiting, so a process
+        // piping one command at a time still gets each answer straight away.
+        // Returns the number of commands executed.
+        size_t runCommands(std::istream& in, std::ostream& out);
+        // The same commands for front ends that do their own I/O (the socket
+        // server): executes every complete line at the front of `input`,
+        // removes them and appends their responses; a trailing partial line
+        // is left for later (or run too, if `final`). Call between
+        // beginCommandBatch and endCommandBatch, and send the responses only
+        // after endCommandBatch, which makes the batch durable.
+        size_t runCommandLines(std::string_view& input, std::string& responses, bool final = false);
+        void beginCommandBatch();
+        void endCommandBatch();
 };
 #endif
\ No newline at end of file
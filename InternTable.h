@@ -0,0 +1,264 @@
+#ifndef INTERNTABLE_H
+#define INTERNTABLE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Compact handle for an interned ID or name.
+typedef uint32_t NameId;
+const NameId NO_NAME = 0xFFFFFFFFu;
+
+// Process-wide table of the patient and doctor IDs and names in use. Each
+// distinct string is stored once and records refer to it by a 4-byte NameId,
+// so appointments, waiting patients and triage entries are small plain
+// structs instead of carrying their own std::string copies. NameId 0 is "".
+//
+// Strings live in fixed-size chunks that never move, so str() takes no lock;
+// a NameId is only handed out after its string is in place. Lookups go to one
+// of SHARDS independently locked open-addressing tables of (hash, NameId), so
+// a string is only compared when its hash matches. Only what is actually
+// stored gets interned (HospitalSystem interns a request's patient only once
+// the booking is accepted).
+//
+// Names no record uses any more are released by collect(), which
+// HospitalSystem runs at startDay: the owners of records register roots that
+// mark every NameId they hold, and a name neither marked nor looked up since
+// the previous collect is freed and its NameId reused. A NameId therefore
+// stays valid until the second collect after its last record went away, so
+// ids copied out of a view or result must not be kept across days. Past
+// MAX_CHUNKS * CHUNK_SIZE live strings, intern returns NO_NAME.
+class InternTable{
+    public:
+        // Calls mark on every NameId a set of records holds.
+        typedef std::function<void(NameId)> Mark;
+        typedef std::function<void(const Mark&)> Root;
+    private:
+        static const int CHUNK_BITS = 16;
+        static const uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+        static const uint32_t MAX_CHUNKS = 4096;
+        static const size_t SHARDS = 16;
+        static const uint32_t FREE = 0xFFFFFFFFu; // seen[] of a released NameId
+
+        struct Entry{
+            uint32_t hash; // hash bits above the shard bits
+            NameId id;     // NO_NAME = empty
+        };
+        struct Shard{
+            mutable std::shared_mutex lock;
+            std::vector<Entry> slots; // power-of-two size
+            size_t used = 0;
+        };
+
+        struct Chunk{
+            std::string strings[CHUNK_SIZE];
+            std::atomic<uint32_t> seen[CHUNK_SIZE]; // last collect epoch that saw the name
+        };
+
+        std::atomic<Chunk*> chunks[MAX_CHUNKS];
+        std::atomic<uint32_t> nextId;
+        std::atomic<uint32_t> epoch;
+        Shard shards[SHARDS];
+        std::mutex freeLock;          // after a shard lock, never before
+        std::vector<NameId> freeIds;  // released, for store to reuse
+        std::mutex sweepLock;         // one collect at a time; guards roots
+        std::vector<std::pair<size_t, Root>> roots;
+        size_t nextRoot = 0;
+
+        Chunk& chunkOf(NameId id) const { return *chunks[id >> CHUNK_BITS].load(std::memory_order_acquire); };
+        std::atomic<uint32_t>& seenOf(NameId id) const { return chunkOf(id).seen[id & (CHUNK_SIZE - 1)]; };
+        // Keeps the name through the next collect. Skips the store when it
+        // is already current, so hot names do not bounce a cache line.
+        void touch(NameId id) const{
+            std::atomic<uint32_t>& seen = seenOf(id);
+            uint32_t now = epoch.load(std::memory_order_relaxed);
+            if(seen.load(std::memory_order_relaxed) != now) seen.store(now, std::memory_order_relaxed);
+        };
+
+        static size_t hashOf(std::string_view s){ return std::hash<std::string_view>()(s); };
+
+        bool lookup(const Shard& shard, std::string_view s, uint32_t hash, NameId& id) const{
+            if(shard.slots.empty()) return false;
+            size_t mask = shard.slots.size() - 1;
+            for(size_t i = hash & mask; ; i = (i + 1) & mask){
+                const Entry& e = shard.slots[i];
+                if(e.id == NO_NAME) return false;
+                if(e.hash == hash && str(e.id) == s){
+                    id = e.id;
+                    return true;
+                };
+            };
+        };
+        static void place(Shard& shard, const Entry& e){
+            size_t mask = shard.slots.size() - 1;
+            size_t i = e.hash & mask;
+            while(shard.slots[i].id != NO_NAME) i = (i + 1) & mask;
+            shard.slots[i] = e;
+        };
+        static void grow(Shard& shard){
+            std::vector<Entry> old;
+            old.swap(shard.slots);
+            shard.slots.assign(old.empty() ? 64 : old.size() * 2, Entry{0, NO_NAME});
+            for(const Entry& e : old){
+                if(e.id != NO_NAME) place(shard, e);
+            };
+        };
+        // A released NameId if there is one, else a new one; NO_NAME once
+        // every chunk is used.
+        NameId store(std::string_view s){
+            NameId id = NO_NAME;
+            {
+                std::lock_guard<std::mutex> guard(freeLock);
+                if(!freeIds.empty()){
+                    id = freeIds.back();
+                    freeIds.pop_back();
+                };
+            }
+            if(id == NO_NAME){
+                id = nextId.load();
+                do{
+                    if(id >= MAX_CHUNKS * CHUNK_SIZE) return NO_NAME;
+                }while(!nextId.compare_exchange_weak(id, id + 1));
+            };
+            std::atomic<Chunk*>& slot = chunks[id >> CHUNK_BITS];
+            Chunk* chunk = slot.load(std::memory_order_acquire);
+            if(!chunk){
+                // First string of a new chunk; another shard may race us here.
+                Chunk* fresh = new Chunk();
+                if(slot.compare_exchange_strong(chunk, fresh, std::memory_order_acq_rel)){
+                    chunk = fresh;
+                }else{
+                    delete fresh;
+                };
+            };
+            chunk->strings[id & (CHUNK_SIZE - 1)] = std::string(s);
+            chunk->seen[id & (CHUNK_SIZE - 1)].store(epoch.load(), std::memory_order_relaxed);
+            return id;
+        };
+    public:
+        InternTable() : nextId(0), epoch(1){
+            for(auto& c : chunks) c.store(nullptr, std::memory_order_relaxed);
+            intern("");
+        };
+        InternTable(const InternTable&) = delete;
+        InternTable& operator=(const InternTable&) = delete;
+        ~InternTable(){
+            for(auto& c : chunks) delete c.load(std::memory_order_relaxed);
+        };
+
+        // The string's NameId, added if new; NO_NAME if the table is full.
+        NameId intern(std::string_view s){
+            size_t full = hashOf(s);
+            Shard& shard = shards[full % SHARDS];
+            uint32_t hash = static_cast<uint32_t>(full / SHARDS);
+            NameId id;
+            {
+                std::shared_lock<std::shared_mutex> guard(shard.lock);
+                if(lookup(shard, s, hash, id)){
+                    touch(id);
+                    return id;
+                };
+            }
+            std::unique_lock<std::shared_mutex> guard(shard.lock);
+            if(lookup(shard, s, hash, id)){
+                touch(id);
+                return id;
+            };
+            if((shard.used + 1) * 2 > shard.slots.size()) grow(shard);
+            id = store(s);
+            if(id == NO_NAME) return NO_NAME;
+            place(shard, Entry{hash, id});
+            shard.used++;
+            return id;
+        };
+        // Like intern, but never adds: false if the string was never seen.
+        bool find(std::string_view s, NameId& id) const{
+            size_t full = hashOf(s);
+            const Shard& shard = shards[full % SHARDS];
+            std::shared_lock<std::shared_mutex> guard(shard.lock);
+            if(!lookup(shard, s, static_cast<uint32_t>(full / SHARDS), id)) return false;
+            touch(id);
+            return true;
+        };
+        const std::string& str(NameId id) const{
+            return chunkOf(id).strings[id & (CHUNK_SIZE - 1)];
+        };
+        // Names in use, released ones not counted.
+        size_t size(){
+            std::lock_guard<std::mutex> guard(freeLock);
+            return nextId.load() - freeIds.size();
+        };
+        static size_t capacity() { return static_cast<size_t>(MAX_CHUNKS) * CHUNK_SIZE; };
+
+        // Registers records whose names collect must keep; the handle is for
+        // removeRoot, which must be called before the records go away.
+        size_t addRoot(Root root){
+            std::lock_guard<std::mutex> guard(sweepLock);
+            roots.emplace_back(nextRoot, std::move(root));
+            return nextRoot++;
+        };
+        void removeRoot(size_t handle){
+            std::lock_guard<std::mutex> guard(sweepLock);
+            roots.erase(std::remove_if(roots.begin(), roots.end(),
+                [handle](const std::pair<size_t, Root>& r){ return r.first == handle; }), roots.end());
+        };
+        // Releases every name that no root marked and nothing looked up
+        // since the previous collect; returns how many. Call with no record
+        // lock held, since the roots take their own.
+        size_t collect(){
+            std::lock_guard<std::mutex> sweep(sweepLock);
+            uint32_t now = ++epoch;
+            for(const auto& r : roots){
+                r.second([this, now](NameId id){
+                    if(id != NO_NAME) seenOf(id).store(now, std::memory_order_relaxed);
+                });
+            };
+            std::vector<std::unique_lock<std::shared_mutex>> held;
+            for(Shard& shard : shards) held.emplace_back(shard.lock);
+            // No intern can run now, so nextId and every seen[] are settled.
+            std::vector<bool> released;
+            size_t count = 0;
+            uint32_t limit = nextId.load();
+            {
+                std::lock_guard<std::mutex> guard(freeLock);
+                released.assign(limit, false);
+                for(NameId id = 1; id < limit; id++){
+                    std::atomic<uint32_t>& seen = seenOf(id);
+                    uint32_t last = seen.load(std::memory_order_relaxed);
+                    if(last == FREE || last + 1 >= now) continue;
+                    seen.store(FREE, std::memory_order_relaxed);
+                    std::string().swap(chunkOf(id).strings[id & (CHUNK_SIZE - 1)]);
+                    freeIds.push_back(id);
+                    released[id] = true;
+                    count++;
+                };
+            }
+            if(count == 0) return 0;
+            for(Shard& shard : shards){
+                std::vector<Entry> old;
+                old.swap(shard.slots);
+                shard.slots.assign(old.size(), Entry{0, NO_NAME});
+                shard.used = 0;
+                for(const Entry& e : old){
+                    if(e.id == NO_NAME || released[e.id]) continue;
+                    place(shard, e);
+                    shard.used++;
+                };
+            };
+            return count;
+        };
+};
+
+// The table every HospitalSystem in the process shares.
+inline InternTable& names(){
+    static InternTable table;
+    return table;
+}
+
+#endif
@@ -0,0 +1,60 @@
+// Load generator for the socket server (hospital_system --serve ADDRESS):
+// several connections pipelining front-desk commands; prints throughput and
+// latency percentiles. Start the server in an empty directory, since the
+// run adds doctors D1..Dn and books into them.
+//
+//   g++ -std=c++17 -O2 LoadClient.cpp -o hospital_load
+//   ./hospital_system --serve 7000 &
+//   ./hospital_load address=7000 connections=8 depth=16 requests=200000
+//
+// Keys (defaults): address=hospital.sock connections=4 depth=16
+// requests=100000 doctors=200 slots=96 schedule=60 cancel=15 call=20 list=5
+// seed=1
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include "CommandClient.h"
+
+int main(int argc, char** argv) {
+    std::map<std::string, std::string> options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            std::fprintf(stderr, "Usage: %s [key=value ...]\n", argv[0]);
+            return 1;
+        }
+        options[arg.substr(0, eq)] = arg.substr(eq + 1);
+    }
+    auto intOption = [&options](const char* key, int fallback) {
+        auto it = options.find(key);
+        return it == options.end() ? fallback : std::atoi(it->second.c_str());
+    };
+
+    std::string address = options.count("address") ? options["address"] : "hospital.sock";
+    LoadConfig cfg;
+    cfg.connections = std::max(1, intOption("connections", cfg.connections));
+    cfg.depth = std::max(1, intOption("depth", cfg.depth));
+    cfg.requests = intOption("requests", cfg.requests);
+    cfg.doctors = std::max(1, intOption("doctors", cfg.doctors));
+    cfg.slots = std::max(1, std::min(intOption("slots", cfg.slots), 16 * 12));
+    cfg.schedule = intOption("schedule", cfg.schedule);
+    cfg.cancel = intOption("cancel", cfg.cancel);
+    cfg.call = intOption("call", cfg.call);
+    cfg.list = intOption("list", cfg.list);
+    cfg.seed = intOption("seed", cfg.seed);
+
+    LoadReport report;
+    if (!runLoad(address, cfg, report)) {
+        std::fprintf(stderr, "Connection to %s failed or broke off\n", address.c_str());
+        return 1;
+    }
+    std::printf("%zu commands over %d connections, %d in flight each: %.0f commands/s\n",
+                report.requests, cfg.connections, cfg.depth, report.requests / report.seconds);
+    std::printf("latency us: p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n", report.percentile(0.50),
+                report.percentile(0.99), report.percentile(0.999), report.percentile(1.0));
+    if (report.errors)
+        std::printf("%zu ERROR responses\n", report.errors);
+    return 0;
+}
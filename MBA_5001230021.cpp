@@ -1,8 +1,105 @@
 #include<iostream>
+#include<fstream>
+#include<cstring>
+#include<memory>
+#include<vector>
+#include<csignal>
+#include<cstdio>
+#include<cstdlib>
 #include "HospitalSystem.h"
 #include "HospitalSystem.cpp"
-int main(){
+#include "HistoryExport.h"
+#ifdef __linux__
+#include "CommandServer.h"
+static CommandServer* runningServer = nullptr;
+static void stopServer(int){ runningServer->stop(); }
+#endif
+// With "--commands [file]" the system runs headless on a command stream
+// (CommandStream.h) from the file, or from stdin, instead of the menu.
+// With "--history" every event is also exported to history-*.csv
+// (HistoryExport.h), in any mode. With "--serve ADDRESS" (repeatable) it
+// serves the command stream on a loopback TCP port or a Unix socket path
+// (CommandServer.h) until SIGINT or SIGTERM. "--aging MINUTES" and
+// "--max-wait LEVEL=MINUTES" (repeatable) set the triage policy
+// (TriageEntry.h) of the call queues.
+int main(int argc, char** argv){
+    bool commands = false, history = false;
+    const char* commandFile = nullptr;
+    std::vector<std::string> serve;
+    TriagePolicy triage;
+    bool usage = false;
+    for(int i = 1; i < argc && !usage; i++){
+        if(std::strcmp(argv[i], "--history") == 0){
+            history = true;
+        }else if(std::strcmp(argv[i], "--aging") == 0 && i + 1 < argc){
+            triage.agingMinutes = std::atoi(argv[++i]);
+            usage = triage.agingMinutes <= 0;
+        }else if(std::strcmp(argv[i], "--max-wait") == 0 && i + 1 < argc){
+            int level = -1, minutes = 0;
+            usage = std::sscanf(argv[++i], "%d=%d", &level, &minutes) != 2 || level < 0 || minutes <= 0;
+            if(!usage){
+                if(static_cast<int>(triage.maxWaitMinutes.size()) <= level) triage.maxWaitMinutes.resize(level + 1, 0);
+                triage.maxWaitMinutes[level] = minutes;
+            };
+        }else if(std::strcmp(argv[i], "--commands") == 0){
+            commands = true;
+            if(i + 1 < argc && argv[i + 1][0] != '-') commandFile = argv[++i];
+        }else if(std::strcmp(argv[i], "--serve") == 0 && i + 1 < argc){
+            serve.push_back(argv[++i]);
+        }else{
+            usage = true;
+        };
+    };
+    if(usage){
+        std::cerr << "Usage: " << argv[0] << " [--history] [--aging MINUTES] [--max-wait LEVEL=MINUTES ...]"
+                  << " [--commands [file] | --serve ADDRESS ...]\n";
+        return 1;
+    };
+
+    // Declared first so it outlives the system that sends to it.
+    std::unique_ptr<HistoryExporter> exporter;
+    if(history) exporter.reset(new HistoryExporter());
     HospitalSystem system;
-    system.runMenu();
+    system.setEventSink(exporter.get());
+    system.setTriagePolicy(triage);
+    if(!serve.empty()){
+#ifdef __linux__
+        CommandServer server(system);
+        for(const std::string& address : serve){
+            if(!server.listenOn(address)){
+                std::cerr << "Cannot listen on " << address << "\n";
+                return 1;
+            };
+        };
+        runningServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        std::signal(SIGPIPE, SIG_IGN);
+        std::cerr << "Serving on";
+        for(const std::string& address : serve) std::cerr << " " << address;
+        std::cerr << "\n";
+        server.run();
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        runningServer = nullptr;
+#else
+        std::cerr << "--serve needs epoll (Linux)\n";
+        return 1;
+#endif
+    }else if(commands){
+        std::ios::sync_with_stdio(false);
+        if(commandFile){
+            std::ifstream in(commandFile);
+            if(!in){
+                std::cerr << "Cannot open " << commandFile << "\n";
+                return 1;
+            };
+            system.runCommands(in, std::cout);
+        }else{
+            system.runCommands(std::cin, std::cout);
+        };
+    }else{
+        system.runMenu();
+    };
     return 0;
-};
\ No newline at end of file
+};
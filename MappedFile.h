@@ -0,0 +1,86 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <string_view>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. Maps it with mmap where available and
+// falls back to reading it into memory (Windows, empty files, pipes).
+class MappedFile{
+    private:
+        const char* base;
+        size_t length;
+        bool mapped;
+        std::string fallback;
+    public:
+        explicit MappedFile(const std::string& path) : base(nullptr), length(0), mapped(false) {
+#ifndef _WIN32
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if(fd >= 0){
+                struct stat st;
+                if(::fstat(fd, &st) == 0 && st.st_size > 0){
+                    void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if(p != MAP_FAILED){
+                        ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+                        base = static_cast<const char*>(p);
+                        length = st.st_size;
+                        mapped = true;
+                    };
+                };
+                ::close(fd);
+                if(mapped) return;
+            };
+#endif
+            std::ifstream in(path, std::ios::binary);
+            if(!in) return;
+            std::ostringstream buf;
+            buf << in.rdbuf();
+            fallback = buf.str();
+            base = fallback.data();
+            length = fallback.size();
+        };
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        ~MappedFile(){
+#ifndef _WIN32
+            if(mapped){
+                ::munmap(const_cast<char*>(base), length);
+            };
+#endif
+        };
+        bool isOpen() const { return base != nullptr; };
+        std::string_view view() const { return std::string_view(base, length); };
+};
+
+// Whitespace tokenizer over a string_view; same token rules as `in >> str`.
+inline bool nextToken(std::string_view& rest, std::string_view& token){
+    size_t i = 0;
+    while(i < rest.size() && (rest[i] == ' ' || rest[i] == '\n' || rest[i] == '\r' || rest[i] == '\t')){
+        i++;
+    };
+    size_t start = i;
+    while(i < rest.size() && !(rest[i] == ' ' || rest[i] == '\n' || rest[i] == '\r' || rest[i] == '\t')){
+        i++;
+    };
+    token = rest.substr(start, i - start);
+    rest.remove_prefix(i);
+    return !token.empty();
+}
+
+inline bool nextInt(std::string_view& rest, int& value){
+    std::string_view token;
+    if(!nextToken(rest, token)) return false;
+    auto result = std::from_chars(token.data(), token.data() + token.size(), value);
+    return result.ec == std::errc() && result.ptr == token.data() + token.size();
+}
+
+#endif
@@ -3,23 +3,38 @@
 
 #include <string>
 #include <iostream>
+#include "InternTable.h"
 
+// A patient as a request names them: built from strings, it holds no keys
+// (NO_NAME), and HospitalSystem interns the strings itself once a booking
+// is accepted, so rejected requests leave no trace in the intern table and
+// a Patient is never written through a const reference. Stored patients
+// (waiting lists) are built from keys.
 class Patient{
     private:
-        std::string patientID;
-        std::string namePAT;
+        NameId patientID;           // interned, see InternTable.h; NO_NAME if built from strings
+        NameId namePAT;
         int priorityLevel;
+        std::string pendingID;      // the strings while not interned yet
+        std::string pendingName;
     public:
-        Patient(std::string pID,std::string namePatient,int PriLevel){
-            patientID = pID;
-            namePAT = namePatient;
-            priorityLevel = PriLevel;
+        Patient(std::string pID,std::string namePatient,int PriLevel)
+        : patientID(NO_NAME), namePAT(NO_NAME), priorityLevel(PriLevel),
+          pendingID(std::move(pID)), pendingName(std::move(namePatient)) {};
+        Patient(NameId pID, NameId namePatient, int PriLevel)
+        : patientID(pID), namePAT(namePatient), priorityLevel(PriLevel) {};
+        const std::string& getpID() const{
+            return patientID == NO_NAME ? pendingID : names().str(patientID);
         };
-        const std::string getpID() const{
+        
+        const std::string& getnamePat() const{
+            return namePAT == NO_NAME ? pendingName : names().str(namePAT);
+        };
+        // NO_NAME for a patient built from strings.
+        NameId getpIDKey() const{
             return patientID;
         };
-        
-        const std::string getnamePat() const{
+        NameId getnamePatKey() const{
             return namePAT;
         };
         const int getpriLevel() const{
@@ -29,16 +44,18 @@ class Patient{
             priorityLevel = inputpriLevel;
         };
         void setnamePat(std::string nameInput){
-            namePAT = nameInput;
+            pendingName = std::move(nameInput);
+            namePAT = NO_NAME;
         };
         void setPID(std::string PIDInput){
-            patientID = PIDInput;
+            pendingID = std::move(PIDInput);
+            patientID = NO_NAME;
         };
         friend std::ostream& operator<<(std::ostream& os, const Patient& p);
 };
 
 inline std::ostream& operator<<(std::ostream& os, const Patient& p) {
-    os << "Name: " << p.namePAT << ", Patient ID : " << p.patientID << "Priority Level: "<< p.priorityLevel<<std::endl;
+    os << "Name: " << p.getnamePat() << ", Patient ID : " << p.getpID() << "Priority Level: "<< p.priorityLevel<<std::endl;
     return os;
 }
 
@@ -0,0 +1,165 @@
+#ifndef PATIENTINDEX_H
+#define PATIENTINDEX_H
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "InternTable.h"
+
+struct PatientLocation{
+    NameId doctorID;
+    int slotMinute;  // slot key (day and minute) of the slot
+    bool waitlisted; // on the slot's waiting list rather than booked
+};
+
+// Hospital-wide patientID -> every slot the patient is booked or waiting in.
+// Kept up to date by HospitalSystem on each schedule, cancel, call, promotion
+// and load, so "where is P?" never walks the doctors' schedules.
+//
+// Patients are split into independently locked shards by interned ID, so
+// front desks booking different patients (for different doctors) do not
+// serialize here. Within a shard, a dense table maps the ID to the patient's
+// places; the first place is stored inline, so the usual one-booking patient
+// costs no allocation. Callers may hold a doctor lock while calling in, never
+// the other way round.
+class PatientIndex{
+    private:
+        static const size_t SHARDS = 64;
+        struct Places{
+            PatientLocation first;
+            uint32_t count;
+            std::vector<PatientLocation> more; // places after the first
+            PatientLocation& at(uint32_t i){ return i == 0 ? first : more[i - 1]; };
+            const PatientLocation& at(uint32_t i) const { return i == 0 ? first : more[i - 1]; };
+        };
+        struct Shard{
+            mutable std::mutex lock;
+            std::vector<uint32_t> slotOf; // patientID / SHARDS -> position in places + 1, 0 = none
+            std::vector<Places> places;
+            std::vector<NameId> owners;   // patientID of each entry in places
+        };
+        Shard shards[SHARDS];
+
+        Shard& shardFor(NameId patientID){ return shards[patientID % SHARDS]; };
+        const Shard& shardFor(NameId patientID) const { return shards[patientID % SHARDS]; };
+
+        static Places* placesOf(Shard& shard, NameId patientID, bool create){
+            size_t key = patientID / SHARDS;
+            if(key >= shard.slotOf.size()){
+                if(!create) return nullptr;
+                shard.slotOf.resize(key + 1, 0);
+            };
+            uint32_t& slot = shard.slotOf[key];
+            if(slot == 0){
+                if(!create) return nullptr;
+                shard.places.push_back(Places{{0, 0, false}, 0, {}});
+                shard.owners.push_back(patientID);
+                slot = static_cast<uint32_t>(shard.places.size());
+            };
+            return &shard.places[slot - 1];
+        };
+        static const Places* placesOf(const Shard& shard, NameId patientID){
+            size_t key = patientID / SHARDS;
+            if(key >= shard.slotOf.size() || shard.slotOf[key] == 0) return nullptr;
+            return &shard.places[shard.slotOf[key] - 1];
+        };
+        static void push(Places& p, const PatientLocation& l){
+            if(p.count == 0) p.first = l;
+            else p.more.push_back(l);
+            p.count++;
+        };
+        static bool removeFrom(Shard& shard, NameId patientID, NameId doctorID,
+                               int slotMinute, bool waitlisted){
+            Places* p = placesOf(shard, patientID, false);
+            if(!p) return false;
+            for(uint32_t i = 0; i < p->count; i++){
+                const PatientLocation& l = p->at(i);
+                if(l.slotMinute == slotMinute && l.waitlisted == waitlisted && l.doctorID == doctorID){
+                    p->at(i) = p->at(p->count - 1);
+                    if(p->count > 1) p->more.pop_back();
+                    p->count--;
+                    return true;
+                };
+            };
+            return false;
+        };
+    public:
+        void add(NameId patientID, NameId doctorID, int slotMinute, bool waitlisted){
+            Shard& shard = shardFor(patientID);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            push(*placesOf(shard, patientID, true), {doctorID, slotMinute, waitlisted});
+        };
+        // Records the place unless the patient already holds one at this
+        // time with any doctor; check and insert are atomic.
+        bool reserve(NameId patientID, NameId doctorID, int slotMinute,
+                     bool waitlisted, PatientLocation* clash){
+            Shard& shard = shardFor(patientID);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            Places& p = *placesOf(shard, patientID, true);
+            for(uint32_t i = 0; i < p.count; i++){
+                if(p.at(i).slotMinute == slotMinute){
+                    if(clash) *clash = p.at(i);
+                    return false;
+                };
+            };
+            push(p, {doctorID, slotMinute, waitlisted});
+            return true;
+        };
+        // True, with the place in clash, if the patient holds one at this time.
+        bool holds(NameId patientID, int slotMinute, PatientLocation* clash) const{
+            const Shard& shard = shardFor(patientID);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            const Places* p = placesOf(shard, patientID);
+            for(uint32_t i = 0; p && i < p->count; i++){
+                if(p->at(i).slotMinute == slotMinute){
+                    if(clash) *clash = p->at(i);
+                    return true;
+                };
+            };
+            return false;
+        };
+        bool remove(NameId patientID, NameId doctorID, int slotMinute, bool waitlisted){
+            Shard& shard = shardFor(patientID);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            return removeFrom(shard, patientID, doctorID, slotMinute, waitlisted);
+        };
+        // Waiting list -> appointment in the same slot.
+        void promote(NameId patientID, NameId doctorID, int slotMinute){
+            Shard& shard = shardFor(patientID);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            Places& p = *placesOf(shard, patientID, true);
+            for(uint32_t i = 0; i < p.count; i++){
+                PatientLocation& l = p.at(i);
+                if(l.waitlisted && l.slotMinute == slotMinute && l.doctorID == doctorID){
+                    l.waitlisted = false;
+                    return;
+                };
+            };
+            push(p, {doctorID, slotMinute, false});
+        };
+        // Copy, since another thread may change the entry right after.
+        std::vector<PatientLocation> find(NameId patientID) const{
+            const Shard& shard = shardFor(patientID);
+            std::lock_guard<std::mutex> guard(shard.lock);
+            std::vector<PatientLocation> out;
+            const Places* p = placesOf(shard, patientID);
+            for(uint32_t i = 0; p && i < p->count; i++){
+                out.push_back(p->at(i));
+            };
+            return out;
+        };
+        template <typename Visit>
+        void forEach(Visit visit) const{
+            for(const Shard& shard : shards){
+                std::lock_guard<std::mutex> guard(shard.lock);
+                for(size_t k = 0; k < shard.places.size(); k++){
+                    for(uint32_t i = 0; i < shard.places[k].count; i++){
+                        visit(shard.owners[k], shard.places[k].at(i));
+                    };
+                };
+            };
+        };
+};
+
+#endif
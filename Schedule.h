@@ -0,0 +1,105 @@
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <iterator>
+#include <map>
+#include "SlotTable.h"
+
+// A doctor's slots across days, one SlotTable partition per day that has
+// slots, found by slot key (see SlotTime.h). Iteration runs in key order
+// across the partitions; a range query seeks to its first day and stops after
+// its last, so other days are never touched. Past days are handed out and
+// dropped whole by archiveBefore.
+class Schedule{
+    private:
+        typedef std::map<int, SlotTable> Days;
+        Days days;       // day -> that day's slots, never empty
+        size_t slotCount;
+    public:
+        class const_iterator{
+            private:
+                Days::const_iterator day, last;
+                size_t pos;
+                void skipEnded(){
+                    while(day != last && pos >= day->second.size()){
+                        ++day;
+                        pos = 0;
+                    };
+                };
+            public:
+                typedef std::forward_iterator_tag iterator_category;
+                typedef TimeSlotInfo value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const TimeSlotInfo* pointer;
+                typedef const TimeSlotInfo& reference;
+
+                const_iterator(Days::const_iterator d, Days::const_iterator l, size_t p)
+                : day(d), last(l), pos(p) { skipEnded(); };
+                reference operator*() const { return day->second.at(pos); };
+                pointer operator->() const { return &day->second.at(pos); };
+                const_iterator& operator++(){ pos++; skipEnded(); return *this; };
+                bool operator==(const const_iterator& o) const { return day == o.day && pos == o.pos; };
+                bool operator!=(const const_iterator& o) const { return !(*this == o); };
+        };
+
+        Schedule() : slotCount(0) {};
+
+        TimeSlotInfo* find(int key){
+            auto it = days.find(slotDay(key));
+            return it == days.end() ? nullptr : it->second.find(slotMinuteOfDay(key));
+        };
+        const TimeSlotInfo* find(int key) const{
+            auto it = days.find(slotDay(key));
+            return it == days.end() ? nullptr : it->second.find(slotMinuteOfDay(key));
+        };
+        // Returns the existing slot if there is one. Pointers to other slots
+        // stay valid.
+        TimeSlotInfo* insert(int key, int capacity){
+            SlotTable& table = days.try_emplace(slotDay(key), slotDay(key)).first->second;
+            size_t before = table.size();
+            TimeSlotInfo* slot = table.insert(slotMinuteOfDay(key), capacity);
+            slotCount += table.size() - before;
+            return slot;
+        };
+        // A day left without slots is dropped with its last one.
+        bool erase(int key){
+            auto it = days.find(slotDay(key));
+            if(it == days.end() || !it->second.erase(slotMinuteOfDay(key))) return false;
+            if(it->second.empty()) days.erase(it);
+            slotCount--;
+            return true;
+        };
+        // First slot with a key at or after key.
+        const_iterator lowerBound(int key) const{
+            auto it = days.lower_bound(slotDay(key));
+            size_t pos = 0;
+            if(it != days.end() && it->first == slotDay(key)) pos = it->second.lowerBound(slotMinuteOfDay(key));
+            return const_iterator(it, days.end(), pos);
+        };
+        // Slots with from <= key <= to, in time order.
+        std::pair<const_iterator, const_iterator> range(int from, int to) const{
+            if(to < from) return std::make_pair(end(), end());
+            return std::make_pair(lowerBound(from), lowerBound(to + 1));
+        };
+        // Hands every slot of the days before `day` to visit, oldest first,
+        // then drops those days. Returns the number of slots dropped.
+        template <typename Visit>
+        size_t archiveBefore(int day, Visit visit){
+            size_t dropped = 0;
+            auto stop = days.lower_bound(day);
+            for(auto it = days.begin(); it != stop; ++it){
+                for(size_t i = 0; i < it->second.size(); i++) visit(it->second.at(i));
+                dropped += it->second.size();
+            };
+            days.erase(days.begin(), stop);
+            slotCount -= dropped;
+            return dropped;
+        };
+        size_t dayCount() const { return days.size(); };
+        bool empty() const { return slotCount == 0; };
+        size_t size() const { return slotCount; };
+        const_iterator begin() const { return const_iterator(days.begin(), days.end(), 0); };
+        const_iterator end() const { return const_iterator(days.end(), days.end(), 0); };
+};
+
+#endif
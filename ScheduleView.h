@@ -0,0 +1,230 @@
+#ifndef SCHEDULEVIEW_H
+#define SCHEDULEVIEW_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "DoctorShard.h"
+
+// Read-only copies of the doctors' schedules for reports. Readers load a
+// doctor's current DoctorView with std::atomic_load and use it without any
+// lock; a view is never modified after it is published and stays valid for
+// as long as the reader holds the shared_ptr.
+//
+// Writers note which slots they changed (DoctorShard::keyChanged) and
+// publish the next version as they let go of the doctor's lock
+// (ShardGuard). Readers never take that lock, so reports never slow down
+// scheduling beyond the copy each change makes.
+//
+// Publishing is copy-on-write by day: a day with a changed slot is copied
+// from the previous version with only that slot read again from the live
+// schedule; the other days are shared with the previous version.
+
+struct BookingView{
+    NameId patientID;
+    NameId patientName;
+    int priorityLevel;
+};
+
+struct SlotView{
+    int key;      // slot key, see SlotTime.h
+    int capacity;
+    int first;    // index of the slot's first booking in DayView::people
+    int booked;   // bookings, followed by `waiting` waiting patients
+    int waiting;
+};
+
+// One day of one doctor's schedule, slots in time order.
+struct DayView{
+    int day;
+    std::vector<SlotView> slots;
+    std::vector<BookingView> people;
+
+    const BookingView* bookings(const SlotView& s) const { return people.data() + s.first; };
+    const BookingView* waitingList(const SlotView& s) const { return people.data() + s.first + s.booked; };
+    const SlotView* find(int key) const{
+        auto it = std::lower_bound(slots.begin(), slots.end(), key,
+                                   [](const SlotView& s, int k){ return s.key < k; });
+        return it != slots.end() && it->key == key ? &*it : nullptr;
+    };
+};
+
+struct DoctorView{
+    uint64_t version; // 1 for the first view, +1 per publication
+    std::string doctorID;
+    std::string name;
+    std::string specialty;
+    DoctorLoad load;
+    std::vector<AvailabilityRule> rules;
+    std::vector<std::shared_ptr<const DayView>> days; // in day order, none empty
+
+    const DayView* findDay(int day) const{
+        auto it = std::lower_bound(days.begin(), days.end(), day,
+                                   [](const std::shared_ptr<const DayView>& d, int k){ return d->day < k; });
+        return it != days.end() && (*it)->day == day ? it->get() : nullptr;
+    };
+    size_t slotCount() const{
+        size_t n = 0;
+        for(const auto& d : days) n += d->slots.size();
+        return n;
+    };
+};
+
+// Appends a live slot with its bookings and waiting list to day.
+inline void appendSlot(DayView& day, const TimeSlotInfo& slot){
+    SlotView s{slot.getMinute(), slot.getCapacity(), static_cast<int>(day.people.size()), 0, 0};
+    for(const Appointment& a : slot.getAppointments()){
+        day.people.push_back({a.getPatientKey(), a.getPatientNameKey(), a.getPriorityLevel()});
+        s.booked++;
+    };
+    for(const Patient& p : slot.getWaitingList()){
+        day.people.push_back({p.getpIDKey(), p.getnamePatKey(), p.getpriLevel()});
+        s.waiting++;
+    };
+    day.slots.push_back(s);
+}
+
+// Copies one day of the live schedule; null if the day has no slots left.
+inline std::shared_ptr<const DayView> copyDay(const Doctor& doctor, int day){
+    auto copy = std::make_shared<DayView>();
+    copy->day = day;
+    const Schedule& schedule = doctor.getSchedule();
+    for(auto it = schedule.lowerBound(day * MINUTES_PER_DAY);
+        it != schedule.end() && slotDay(it->getMinute()) == day; ++it){
+        appendSlot(*copy, *it);
+    };
+    if(copy->slots.empty()) return nullptr;
+    return copy;
+}
+
+// The previous version of a day (or none) with the slots [first, last)
+// (sorted keys of that day) read again from the live schedule; null if the
+// day has no slots left.
+inline std::shared_ptr<const DayView> patchDay(const Doctor& doctor, int day, const DayView* previous,
+                                               const int* first, const int* last){
+    auto copy = std::make_shared<DayView>();
+    copy->day = day;
+    const SlotView* old = previous ? previous->slots.data() : nullptr;
+    size_t kept = previous ? previous->slots.size() : 0, i = 0;
+    if(previous){
+        copy->slots.reserve(kept + (last - first));
+        copy->people.reserve(previous->people.size() + 4);
+    };
+    while(true){
+        // The unchanged slots before the next changed one, in one block.
+        size_t run = first == last ? kept :
+            std::lower_bound(old + i, old + kept, *first, [](const SlotView& s, int k){ return s.key < k; }) - old;
+        if(run > i){
+            int from = old[i].first;
+            int to = run < kept ? old[run].first : static_cast<int>(previous->people.size());
+            int shift = static_cast<int>(copy->people.size()) - from;
+            copy->people.insert(copy->people.end(), previous->people.begin() + from, previous->people.begin() + to);
+            for(; i < run; i++){
+                copy->slots.push_back(old[i]);
+                copy->slots.back().first += shift;
+            };
+        };
+        if(first == last) break;
+        if(i < kept && old[i].key == *first) i++;
+        if(const TimeSlotInfo* slot = doctor.getTimeSlot(*first)) appendSlot(*copy, *slot);
+        ++first;
+    };
+    if(copy->slots.empty()) return nullptr;
+    return copy;
+}
+
+// Publishes a new view of the doctor if anything changed since the last
+// one. Call with the doctor's lock held (or while nothing else can run).
+inline void publishView(const DoctorShard& shard){
+    std::shared_ptr<const DoctorView> previous = shard.view;
+    if(previous && !shard.viewStale) return;
+    shard.viewStale = false;
+
+    auto next = std::make_shared<DoctorView>();
+    const Doctor& d = shard.doctor;
+    next->version = previous ? previous->version + 1 : 1;
+    next->doctorID = d.getdID();
+    next->name = d.getdName();
+    next->specialty = d.getdSpecialty();
+    next->load = shard.load;
+    next->rules = d.getAvailability().getRules();
+
+    if(!previous){
+        for(const TimeSlotInfo& slot : d.getSchedule()){
+            if(next->days.empty() || next->days.back()->day != slotDay(slot.getMinute()))
+                next->days.push_back(copyDay(d, slotDay(slot.getMinute())));
+        };
+    }else{
+        // Merge the previous days with patched copies of the changed ones.
+        std::vector<int>& changed = shard.changedSlots;
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+        next->days.reserve(previous->days.size() + 1);
+        auto old = previous->days.begin();
+        for(size_t i = 0, end = 0; i < changed.size(); i = end){
+            int day = slotDay(changed[i]);
+            for(end = i; end < changed.size() && slotDay(changed[end]) == day; end++){};
+            for(; old != previous->days.end() && (*old)->day < day; ++old) next->days.push_back(*old);
+            const DayView* base = nullptr;
+            if(old != previous->days.end() && (*old)->day == day) base = (old++)->get();
+            if(std::shared_ptr<const DayView> copy = patchDay(d, day, base, &changed[i], changed.data() + end))
+                next->days.push_back(copy);
+        };
+        next->days.insert(next->days.end(), old, previous->days.end());
+    };
+    shard.changedSlots.clear();
+    std::atomic_store(&shard.view, std::shared_ptr<const DoctorView>(std::move(next)));
+}
+
+// The doctor's latest published view.
+inline std::shared_ptr<const DoctorView> currentView(const DoctorShard& shard){
+    return std::atomic_load(&shard.view);
+}
+
+// Holds a doctor's lock for a change and publishes the change (publishView)
+// before letting go. A moved-from guard holds nothing.
+class ShardGuard{
+    private:
+        const DoctorShard* shard;
+        std::unique_lock<std::mutex> guard;
+    public:
+        explicit ShardGuard(const DoctorShard& s) : shard(&s), guard(s.lock) {};
+        ShardGuard(ShardGuard&&) = default;
+        ShardGuard& operator=(ShardGuard&&) = default;
+        ~ShardGuard(){
+            if(guard.owns_lock()) publishView(*shard);
+        };
+};
+
+// Every doctor in ID order, republished (as a whole) only when a doctor is
+// added. The IDs point at HospitalSystem's map keys; neither they nor the
+// shards ever move.
+typedef std::vector<std::pair<const std::string*, const DoctorShard*>> DoctorDirectory;
+
+inline const DoctorShard* findInDirectory(const DoctorDirectory& all, const std::string& doctorID){
+    auto it = std::lower_bound(all.begin(), all.end(), doctorID,
+                               [](const DoctorDirectory::value_type& e, const std::string& id){ return *e.first < id; });
+    return it != all.end() && *it->first == doctorID ? it->second : nullptr;
+}
+
+// One slot as viewDoctorSchedule prints it: capacity, bookings, waiting list.
+inline void printSlotView(const DayView& day, const SlotView& s){
+    std::cout << "Time Slot Capacity: " << s.capacity << "\n";
+    std::cout << "Appointments ( " << s.booked << " ) at " << formatSlotTime(s.key) << "\n";
+    for(const BookingView* b = day.bookings(s); b != day.bookings(s) + s.booked; ++b){
+        std::cout << "  " << names().str(b->patientID) << " - " << names().str(b->patientName)
+                  << " (priority " << b->priorityLevel << ")\n";
+    };
+    std::cout << "Waiting List:\n";
+    for(const BookingView* b = day.waitingList(s); b != day.waitingList(s) + s.waiting; ++b){
+        std::cout << "  " << names().str(b->patientID) << " - " << names().str(b->patientName)
+                  << " (priority " << b->priorityLevel << ")\n";
+    };
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef SLOTTABLE_H
+#define SLOTTABLE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "SlotTime.h"
+#include "Timeslotinfo.h"
+
+// A doctor's slots for one day. Slots stay where they were created, in a
+// deque whose erased entries are reused, so a pointer to a slot survives
+// inserts and erases of others. Only the sorted minute-of-day vector (and the
+// pool position next to each minute) is kept in time order, for printing and
+// range queries; lookups binary-search it, O(log slots) over at most a day's
+// slots. Takes minutes of day; the slots themselves carry full slot keys.
+class SlotTable{
+    private:
+        int day;
+        std::vector<uint16_t> minutes;   // sorted
+        std::vector<uint32_t> positions; // parallel to minutes: index in pool
+        std::deque<TimeSlotInfo> pool;
+        std::vector<uint32_t> unused;    // pool entries of erased slots
+
+        // Index into minutes of minute, or minutes.size() if it has no slot.
+        size_t search(int minute) const{
+            size_t at = lowerBound(minute);
+            return at < minutes.size() && minutes[at] == minute ? at : minutes.size();
+        };
+    public:
+        explicit SlotTable(int d) : day(d) {};
+
+        TimeSlotInfo* find(int minute){
+            size_t at = search(minute);
+            return at == minutes.size() ? nullptr : &pool[positions[at]];
+        };
+        const TimeSlotInfo* find(int minute) const{
+            size_t at = search(minute);
+            return at == minutes.size() ? nullptr : &pool[positions[at]];
+        };
+        // Returns the existing slot if there is one.
+        TimeSlotInfo* insert(int minute, int capacity){
+            size_t at = lowerBound(minute);
+            if(at < minutes.size() && minutes[at] == minute) return &pool[positions[at]];
+            TimeSlotInfo slot(day * MINUTES_PER_DAY + minute, capacity);
+            uint32_t position;
+            if(unused.empty()){
+                position = static_cast<uint32_t>(pool.size());
+                pool.push_back(std::move(slot));
+            }else{
+                position = unused.back();
+                unused.pop_back();
+                pool[position] = std::move(slot);
+            };
+            minutes.insert(minutes.begin() + at, static_cast<uint16_t>(minute));
+            positions.insert(positions.begin() + at, position);
+            return &pool[position];
+        };
+        bool erase(int minute){
+            size_t at = search(minute);
+            if(at == minutes.size()) return false;
+            // Replaced by an empty slot so its bookings' memory goes now.
+            pool[positions[at]] = TimeSlotInfo(0, 0);
+            unused.push_back(positions[at]);
+            minutes.erase(minutes.begin() + at);
+            positions.erase(positions.begin() + at);
+            return true;
+        };
+        // Position of the first slot at or after minute.
+        size_t lowerBound(int minute) const{
+            return std::lower_bound(minutes.begin(), minutes.end(), minute) - minutes.begin();
+        };
+        // The slot at a position in time order.
+        const TimeSlotInfo& at(size_t i) const { return pool[positions[i]]; };
+        int getDay() const { return day; };
+        bool empty() const { return minutes.empty(); };
+        size_t size() const { return minutes.size(); };
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef SLOTTIME_H
+#define SLOTTIME_H
+
+#include <ctime>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+// Time slots are kept as one integer key: minutes since 1970-01-01 00:00 on
+// the local calendar, i.e. day * MINUTES_PER_DAY + minute of day, so keys
+// sort by date and time. Strings only appear at the edges (menu input, text
+// files, printing): "YYYY-MM-DDTHH:MM", or a bare "HH:MM" that the caller
+// places on a default day (today).
+const int MINUTES_PER_DAY = 24 * 60;
+const int FIRST_SLOT_YEAR = 1970;
+const int LAST_SLOT_YEAR = 4000; // keeps every key within an int
+
+inline int slotDay(int key){ return key / MINUTES_PER_DAY; }
+inline int slotMinuteOfDay(int key){ return key % MINUTES_PER_DAY; }
+
+// Days since 1970-01-01 of a proleptic Gregorian date.
+inline int daysFromCivil(int year, int month, int day){
+    year -= month <= 2;
+    int era = year / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+inline void civilFromDays(int days, int& year, int& month, int& day){
+    days += 719468;
+    int era = days / 146097;
+    int dayOfEra = days - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int mp = (5 * dayOfYear + 2) / 153;
+    day = dayOfYear - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
+}
+
+inline bool digitsAt(std::string_view text, std::initializer_list<int> at){
+    for(int i : at){
+        if(text[i] < '0' || text[i] > '9') return false;
+    };
+    return true;
+}
+
+// Returns the minute of day for "HH:MM", or -1 if the text is not a valid time.
+inline int parseClock(std::string_view time){
+    if(time.length() != 5 || time[2] != ':' || !digitsAt(time, {0, 1, 3, 4})) return -1;
+    int hours = (time[0]-'0')*10 + (time[1]-'0');
+    int minutes = (time[3]-'0')*10 + (time[4]-'0');
+    if(hours >= 24 || minutes >= 60) return -1;
+    return hours * 60 + minutes;
+}
+
+// Returns the day number for "YYYY-MM-DD", or -1 if it is not a real date.
+inline int parseDate(std::string_view date){
+    if(date.length() != 10 || date[4] != '-' || date[7] != '-' ||
+       !digitsAt(date, {0, 1, 2, 3, 5, 6, 8, 9})) return -1;
+    int year = (date[0]-'0')*1000 + (date[1]-'0')*100 + (date[2]-'0')*10 + (date[3]-'0');
+    int month = (date[5]-'0')*10 + (date[6]-'0');
+    int day = (date[8]-'0')*10 + (date[9]-'0');
+    if(year < FIRST_SLOT_YEAR || year > LAST_SLOT_YEAR || month < 1 || month > 12 || day < 1) return -1;
+    int days = daysFromCivil(year, month, day);
+    int y, m, d;
+    civilFromDays(days, y, m, d);
+    return m == month ? days : -1; // rejects e.g. 02-30
+}
+
+// Slot key for "YYYY-MM-DDTHH:MM", or for "HH:MM" on defaultDay; -1 if invalid.
+inline int parseSlotTime(std::string_view text, int defaultDay){
+    int day = defaultDay;
+    if(text.length() == 16){
+        if(text[10] != 'T') return -1;
+        day = parseDate(text.substr(0, 10));
+        text.remove_prefix(11);
+    };
+    int minute = parseClock(text);
+    if(day < 0 || minute < 0) return -1;
+    return day * MINUTES_PER_DAY + minute;
+}
+
+inline std::string formatClock(int minuteOfDay){
+    std::string time = "00:00";
+    time[0] = static_cast<char>('0' + minuteOfDay / 600);
+    time[1] = static_cast<char>('0' + minuteOfDay / 60 % 10);
+    time[3] = static_cast<char>('0' + minuteOfDay % 60 / 10);
+    time[4] = static_cast<char>('0' + minuteOfDay % 10);
+    return time;
+}
+
+inline std::string formatDate(int days){
+    int year, month, day;
+    civilFromDays(days, year, month, day);
+    std::string date = "0000-00-00";
+    for(int i = 3; i >= 0; i--, year /= 10) date[i] = static_cast<char>('0' + year % 10);
+    date[5] = static_cast<char>('0' + month / 10);
+    date[6] = static_cast<char>('0' + month % 10);
+    date[8] = static_cast<char>('0' + day / 10);
+    date[9] = static_cast<char>('0' + day % 10);
+    return date;
+}
+
+// Always the full "YYYY-MM-DDTHH:MM" form, so files and journals stay
+// unambiguous across days.
+inline std::string formatSlotTime(int key){
+    return formatDate(slotDay(key)) + "T" + formatClock(slotMinuteOfDay(key));
+}
+
+// A time broken down on the local clock.
+inline std::tm localTime(std::time_t t){
+    std::tm local;
+#ifdef _WIN32
+    localtime_s(&local, &t);
+#else
+    localtime_r(&t, &local);
+#endif
+    return local;
+}
+
+inline std::tm localNow(){
+    return localTime(std::time(nullptr));
+}
+
+// Today's day number on the local clock.
+inline int currentDay(){
+    std::tm local = localNow();
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+// The slot key of the current minute on the local clock.
+inline int currentSlotKey(){
+    std::tm local = localNow();
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * MINUTES_PER_DAY +
+           local.tm_hour * 60 + local.tm_min;
+}
+
+#endif
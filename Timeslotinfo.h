@@ -3,27 +3,29 @@
 #include <vector>
 #include <string>
 #include <iostream>
-#include<queue>
 #include "Patient.h"
+#include "SlotTime.h"
 
 #include "Appointment.h"
+#include "AppointmentList.h"
+#include "WaitingList.h"
 
 class TimeSlotInfo{
     private:
-        std::string timeSlot;
+        int minute; // slot key (day and minute), see SlotTime.h
         int capacity;
-        std::vector<Appointment> appointments;
-        std::queue<Patient> waitingList;
+        AppointmentList appointments; // O(1) lookup/removal by patient ID
+        WaitingList waitingList;      // most urgent first, O(log n) removal
     public:
-        TimeSlotInfo(const std::string ts,int c) : timeSlot(ts),capacity(c){};
-        bool isFullAppointments(){
-            if(appointments.size() == capacity){
+        TimeSlotInfo(int m,int c) : minute(m),capacity(c){};
+        bool isFullAppointments() const{
+            if(appointments.size() >= capacity){
                 return true;
             }else{
                 return false;
             };
         };
-        bool isFullWaitingList(){
+        bool isFullWaitingList() const{
             if(waitingList.size() >= capacity){
                 return true;
             }else{
@@ -35,44 +37,42 @@ class TimeSlotInfo{
                 // Guard: slot is full, caller should handle waiting list.
                 return false;
             };
-            appointments.push_back(a);
-            return true;
+            // Also false for a patient already booked here; callers check
+            // hasAppointment first when they need to tell the two apart.
+            return appointments.push_back(a);
         };
-        bool removeAppointmentByPatientID(const std::string& patientID1){
-            if(appointments.empty()){
-                std::cout<<"There are no appointments in this slot to remove."<<std::endl;
-                return false;
-            };
-            for(size_t i = 0 ; i < appointments.size() ; i++ ){
-                if(appointments[i].getPatientID() == patientID1){
-                    std::cout<<"Patient Appointment find."<<std::endl;
-                    appointments.erase(appointments.begin() + i);
-                    return true;
-                };
-            };
-            std::cout<<"There is no appointment on this Patient ID."<<std::endl;
-            return false;    
+        bool hasAppointment(NameId patientID1) const{
+            return appointments.contains(patientID1);
+        };
+        bool eraseAppointment(NameId patientID1){
+            return appointments.erase(patientID1);
         };
-        void addToWaitingList(const Patient& p){
+        // False if the patient has no appointment here; the caller reports it.
+        bool removeAppointmentByPatientID(NameId patientID1){
+            return eraseAppointment(patientID1);
+        };
+        bool addToWaitingList(const Patient& p){
             if(isFullWaitingList()){
-                std::cout<<"Waiting List is Full .We can't add!"<<std::endl;
-                return;
+                return false;
             };
-            waitingList.push(p);    
+            // False for a patient already waiting here.
+            return waitingList.push(p);
         };
+        // False if the patient is not on this slot's waiting list.
+        bool removeFromWaitingList(NameId patientID1){
+            return waitingList.erase(patientID1);
+        };
+        // Most urgent waiting patient. Return-by-exception is OK here;
+        // callers check emptiness before calling.
         Patient popFromWaitingList(){
-            if(waitingList.empty()){
-                // Return-by-exception is OK here; callers check emptiness before calling.
-                throw std::runtime_error("Error: Waiting List is empty!");
-            };
-            Patient p = waitingList.front();
-            waitingList.pop();
-            return p;
+            return waitingList.pop();
         };
+        int getMinute() const { return minute; }
+        std::string getTimeSlot() const { return formatSlotTime(minute); }
         int getCapacity() const { return capacity; }
         size_t getAppointmentCount() const { return appointments.size(); }
-        const std::vector<Appointment>& getAppointments() const { return appointments; };
-        const std::queue<Patient>& getWaitingList() const { return waitingList; };
+        const AppointmentList& getAppointments() const { return appointments; };
+        const WaitingList& getWaitingList() const { return waitingList; };
 };
 
 #endif
\ No newline at end of file
@@ -1,23 +1,267 @@
 #ifndef TRIAGEENTRY_H
 #define TRIAGEENTRY_H
+#include<algorithm>
 #include<iostream>
+#include<string>
+#include<vector>
+#include "InternTable.h"
+#include "SlotTime.h"
 
+// 24-byte plain record; IDs and names are interned (names().str(id)).
 struct TriageEntry{
     int priorityLevel;
-    std::string patientID;
-    std::string patientName;
-    std::string doctorID;
-    std::string timeSlot;
+    NameId patientID;
+    NameId patientName;
+    NameId doctorID;
+    int slotMinute; // slot key (day and minute) of the booked slot
     int order;
 };
 
+// Triage rule shared by the call queue and the waiting lists: a lower
+// priorityLevel is more urgent, and ties go to whoever came first.
+inline bool triageOutranks(int priorityA, int orderA, int priorityB, int orderB) {
+    if (priorityA == priorityB)
+        return orderA < orderB;
+    return priorityA < priorityB;
+}
+
+// How a doctor's queue orders today's patients beyond the static rule.
+// Waiting time counts from the booked slot's time and is 0 before it; it is
+// taken at call time (TriageQueue::popNext), against the caller's clock.
+struct TriagePolicy{
+    // Aging: every agingMinutes a patient has waited past their slot time
+    // they rank one priority level more urgent. 0 keeps the static rule.
+    int agingMinutes = 0;
+    // SLA: maxWaitMinutes[level] is the longest a patient of that priority
+    // level should wait past the slot time (0, or a level past the end:
+    // no limit). Overdue patients are called before everyone else, the
+    // longest overdue first.
+    std::vector<int> maxWaitMinutes;
+
+    int maxWait(int level) const{
+        return level >= 0 && level < static_cast<int>(maxWaitMinutes.size()) ? maxWaitMinutes[level] : 0;
+    };
+};
+
+// Rank of e under aging at time now (a slot key); lower is called first.
+inline long long agedRank(const TriageEntry& e, int agingMinutes, int now) {
+    return static_cast<long long>(e.priorityLevel) * agingMinutes - std::max(0, now - e.slotMinute);
+}
+
+// Earlier days come first, so today's patients are always at the top of a
+// heap that also holds bookings for later days. Within a day, with aging,
+// priorityLevel * agingMinutes + slot time decides before the static rule:
+// the agedRank order of every patient already past their slot, whatever the
+// clock.
 struct TriageComparator {
+    int agingMinutes = 0;
+
     bool operator()(const TriageEntry& a, const TriageEntry& b) const {
-        if (a.priorityLevel == b.priorityLevel)
-            return a.order > b.order; 
-        return a.priorityLevel > b.priorityLevel;
+        if (slotDay(a.slotMinute) != slotDay(b.slotMinute))
+            return slotDay(a.slotMinute) > slotDay(b.slotMinute);
+        if (agingMinutes > 0) {
+            long long ka = static_cast<long long>(a.priorityLevel) * agingMinutes + slotMinuteOfDay(a.slotMinute);
+            long long kb = static_cast<long long>(b.priorityLevel) * agingMinutes + slotMinuteOfDay(b.slotMinute);
+            if (ka != kb)
+                return ka > kb;
+        }
+        return triageOutranks(b.priorityLevel, b.order, a.priorityLevel, a.order);
     }
 };
 
-#endif
+// Entries of levels with an SLA, by when they become overdue.
+struct DeadlineComparator {
+    const TriagePolicy* policy;
+
+    int deadline(const TriageEntry& e) const { return e.slotMinute + policy->maxWait(e.priorityLevel); };
+    bool operator()(const TriageEntry& a, const TriageEntry& b) const {
+        if (deadline(a) != deadline(b))
+            return deadline(a) > deadline(b);
+        return triageOutranks(b.priorityLevel, b.order, a.priorityLevel, a.order);
+    }
+};
+
+// One heap per doctor: calling the next patient only touches that doctor's
+// entries. An entry whose appointment was cancelled stays in the heap as a
+// tombstone until it surfaces at the top; the owner reports each one with
+// addStale(), and once tombstones make up most of the heap compact() drops
+// them in one O(k) pass, so stale work never dominates a call.
+//
+// With an SLA in the policy, entries of the levels it covers are also kept
+// in a second heap by deadline. With aging, every entry is also kept in a
+// heap in static order: a patient whose slot is still ahead has waited 0,
+// so the best of them is its top, while the main heap's top is the best of
+// those already waiting; popNext takes the lower agedRank of the two. The
+// copies in these heaps of called or cancelled entries are not counted,
+// just dropped when they surface or when a heap grows past twice the live
+// entries.
+class TriageQueue{
+    private:
+        std::vector<TriageEntry> entries;
+        std::vector<TriageEntry> overdue; // by deadline; SLA levels only
+        std::vector<TriageEntry> ranked;  // static order; aging only
+        size_t stale;
+        TriagePolicy policy;
+
+        TriageComparator order() const { return TriageComparator{policy.agingMinutes}; };
+        DeadlineComparator byDeadline() const { return DeadlineComparator{&policy}; };
+        void rebuild(){
+            std::make_heap(entries.begin(), entries.end(), order());
+            overdue.clear();
+            for(const TriageEntry& e : entries){
+                if(policy.maxWait(e.priorityLevel) > 0) overdue.push_back(e);
+            };
+            std::make_heap(overdue.begin(), overdue.end(), byDeadline());
+            ranked.clear();
+            if(policy.agingMinutes > 0) ranked = entries;
+            std::make_heap(ranked.begin(), ranked.end(), TriageComparator());
+        };
+        void popRanked(){
+            std::pop_heap(ranked.begin(), ranked.end(), TriageComparator());
+            ranked.pop_back();
+        };
+        // Drops the copies isLive rejects once a side heap grows past twice
+        // the live entries.
+        template <typename IsLive, typename Order>
+        void prune(std::vector<TriageEntry>& heap, IsLive isLive, Order by){
+            if(heap.size() <= COMPACT_FROM || heap.size() <= 2 * (entries.size() - stale)) return;
+            heap.erase(std::remove_if(heap.begin(), heap.end(),
+                                      [&](const TriageEntry& e){ return !isLive(e); }),
+                       heap.end());
+            std::make_heap(heap.begin(), heap.end(), by);
+        };
+    public:
+        static const size_t COMPACT_FROM = 32; // tombstones before compaction is considered
+
+        TriageQueue() : stale(0) {};
+        TriageQueue(std::vector<TriageEntry> loaded, const TriagePolicy& p)
+        : entries(std::move(loaded)), stale(0), policy(p) { rebuild(); };
+        // Copies hold their own policy, so the deadline order never points
+        // into another queue.
+        TriageQueue(const TriageQueue& o)
+        : entries(o.entries), overdue(o.overdue), ranked(o.ranked), stale(o.stale), policy(o.policy) {};
+        TriageQueue& operator=(TriageQueue o){
+            entries.swap(o.entries);
+            overdue.swap(o.overdue);
+            ranked.swap(o.ranked);
+            stale = o.stale;
+            policy = std::move(o.policy);
+            return *this;
+        };
+
+        const TriagePolicy& getPolicy() const { return policy; };
+        // Reorders the queue for a new policy: O(k), once per change.
+        void setPolicy(const TriagePolicy& p){
+            policy = p;
+            rebuild();
+        };
 
+        void push(const TriageEntry& e){
+            entries.push_back(e);
+            std::push_heap(entries.begin(), entries.end(), order());
+            if(policy.maxWait(e.priorityLevel) > 0){
+                overdue.push_back(e);
+                std::push_heap(overdue.begin(), overdue.end(), byDeadline());
+            };
+            if(policy.agingMinutes > 0){
+                ranked.push_back(e);
+                std::push_heap(ranked.begin(), ranked.end(), TriageComparator());
+            };
+        };
+        const TriageEntry& top() const { return entries.front(); };
+        void pop(){
+            std::pop_heap(entries.begin(), entries.end(), order());
+            entries.pop_back();
+        };
+        bool empty() const { return entries.empty(); };
+        size_t size() const { return entries.size(); };
+        size_t staleCount() const { return stale; };
+        // Heap order, tombstones included.
+        template <typename Visit>
+        void forEach(Visit visit) const{
+            for(const TriageEntry& e : entries) visit(e);
+        };
+
+        // Takes the next patient to call at time `now` (a slot key) among
+        // the entries of days up to lastDay: the longest overdue one if any
+        // is past its SLA, else the lowest agedRank with aging, else the top
+        // of the queue. Entries isLive rejects
+        // are dropped on the way and counted in stalePops. The caller must
+        // end the returned entry's booking, which makes any other copy of
+        // it a tombstone.
+        template <typename IsLive>
+        bool popNext(int now, int lastDay, IsLive isLive, TriageEntry& next, int& stalePops){
+            prune(overdue, isLive, byDeadline());
+            prune(ranked, isLive, TriageComparator());
+            DeadlineComparator deadlines = byDeadline();
+            while(!overdue.empty() && deadlines.deadline(overdue.front()) <= now &&
+                  slotDay(overdue.front().slotMinute) <= lastDay){
+                TriageEntry e = overdue.front();
+                std::pop_heap(overdue.begin(), overdue.end(), deadlines);
+                overdue.pop_back();
+                if(!isLive(e)) continue;
+                next = e;
+                stale++; // its entry in the main heap
+                return true;
+            };
+            while(!entries.empty() && slotDay(top().slotMinute) <= lastDay){
+                TriageEntry e = top();
+                if(!isLive(e)){
+                    pop();
+                    staleRemoved();
+                    stalePops++;
+                    continue;
+                };
+                // e is live, so ranked holds it and its top is of e's day
+                // or earlier.
+                while(!ranked.empty() && !isLive(ranked.front())) popRanked();
+                if(!ranked.empty()){
+                    const TriageEntry& r = ranked.front();
+                    long long rankR = agedRank(r, policy.agingMinutes, now);
+                    long long rankE = agedRank(e, policy.agingMinutes, now);
+                    if(slotDay(r.slotMinute) < slotDay(e.slotMinute) || rankR < rankE ||
+                       (rankR == rankE && triageOutranks(r.priorityLevel, r.order, e.priorityLevel, e.order))){
+                        next = r;
+                        popRanked();
+                        stale++; // its entry in the main heap
+                        return true;
+                    };
+                };
+                pop();
+                next = e;
+                return true;
+            };
+            return false;
+        };
+
+        // An entry became a tombstone; true once compaction is due.
+        bool addStale(){
+            stale++;
+            return stale > COMPACT_FROM && stale * 2 > entries.size();
+        };
+        // A tombstone was popped.
+        void staleRemoved(){
+            if(stale > 0) stale--;
+        };
+        // Keeps only the entries isLive accepts; returns how many were dropped.
+        template <typename IsLive>
+        size_t compact(IsLive isLive){
+            size_t before = entries.size();
+            entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                         [&](const TriageEntry& e){ return !isLive(e); }),
+                          entries.end());
+            overdue.erase(std::remove_if(overdue.begin(), overdue.end(),
+                                         [&](const TriageEntry& e){ return !isLive(e); }),
+                          overdue.end());
+            ranked.erase(std::remove_if(ranked.begin(), ranked.end(),
+                                        [&](const TriageEntry& e){ return !isLive(e); }),
+                         ranked.end());
+            std::make_heap(entries.begin(), entries.end(), order());
+            std::make_heap(overdue.begin(), overdue.end(), byDeadline());
+            std::make_heap(ranked.begin(), ranked.end(), TriageComparator());
+            stale = 0;
+            return before - entries.size();
+        };
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef WAITINGLIST_H
+#define WAITINGLIST_H
+
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include "Patient.h"
+#include "TriageEntry.h"
+
+// Waiting patients of one slot, most urgent first by the triage rule
+// (priority, then arrival), indexed by patient ID. Adding, promoting the
+// front and removing any given patient are O(log n); iterating visits the
+// patients in promotion order without copying them.
+class WaitingList{
+    private:
+        // A Patient by its interned keys: 16 bytes, no strings.
+        struct Waiting{
+            NameId patientID;
+            NameId patientName;
+            int priorityLevel;
+            int order; // arrival in this list
+
+            Patient patient() const { return Patient(patientID, patientName, priorityLevel); };
+        };
+        struct WaitingOrder{
+            bool operator()(const Waiting& a, const Waiting& b) const{
+                return triageOutranks(a.priorityLevel, a.order, b.priorityLevel, b.order);
+            };
+        };
+        typedef std::set<Waiting, WaitingOrder> Ordered;
+
+        Ordered items;
+        std::unordered_map<NameId, Ordered::iterator> index; // patientID -> entry
+        int nextOrder;
+    public:
+        class const_iterator{
+            private:
+                Ordered::const_iterator it;
+            public:
+                typedef std::bidirectional_iterator_tag iterator_category;
+                typedef Patient value_type;
+                typedef std::ptrdiff_t difference_type;
+                typedef const Patient* pointer;
+                typedef Patient reference; // built from the stored keys
+
+                explicit const_iterator(Ordered::const_iterator i) : it(i) {};
+                reference operator*() const { return it->patient(); };
+                const_iterator& operator++(){ ++it; return *this; };
+                const_iterator& operator--(){ --it; return *this; };
+                bool operator==(const const_iterator& o) const { return it == o.it; };
+                bool operator!=(const const_iterator& o) const { return it != o.it; };
+        };
+
+        WaitingList() : nextOrder(0) {};
+        WaitingList(const WaitingList& o) : nextOrder(0) { *this = o; };
+        WaitingList& operator=(const WaitingList& o){
+            if(this == &o) return *this;
+            items.clear();
+            index.clear();
+            nextOrder = 0;
+            for(const Patient& p : o){
+                push(p);
+            };
+            return *this;
+        };
+        WaitingList(WaitingList&&) = default;
+        WaitingList& operator=(WaitingList&&) = default;
+
+        // Returns false if the patient is already waiting here. p must be
+        // built from keys (see Patient.h).
+        bool push(const Patient& p){
+            NameId id = p.getpIDKey();
+            auto slot = index.find(id);
+            if(slot != index.end()) return false;
+            auto it = items.insert({id, p.getnamePatKey(), p.getpriLevel(), nextOrder++}).first;
+            index.emplace(id, it);
+            return true;
+        };
+        Patient front() const{
+            if(items.empty()){
+                throw std::runtime_error("Error: Waiting List is empty!");
+            };
+            return items.begin()->patient();
+        };
+        Patient pop(){
+            Patient p = front();
+            index.erase(p.getpIDKey());
+            items.erase(items.begin());
+            return p;
+        };
+        bool erase(NameId patientID){
+            auto it = index.find(patientID);
+            if(it == index.end()) return false;
+            items.erase(it->second);
+            index.erase(it);
+            return true;
+        };
+        bool contains(NameId patientID) const { return index.count(patientID) != 0; };
+        size_t size() const { return items.size(); };
+        bool empty() const { return items.empty(); };
+        const_iterator begin() const { return const_iterator(items.begin()); };
+        const_iterator end() const { return const_iterator(items.end()); };
+};
+
+#endif